@@ -0,0 +1,457 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include "diffframe.h"
+
+#define CORPUS_SIZE_DEFAULT (1024 * 1024)
+#define CORPUS_PATH_LEN 256
+
+
+
+typedef struct corpus_scenario_s {
+  const char *name;
+  void (*generate)(void);
+} corpus_scenario_t;
+
+static FILE *corpus_out = NULL;
+static uint32_t corpus_seed = 1;
+
+static const char *corpus_words[] = {
+  "terminal", "buffer", "static", "inline", "uint8_t", "return", "screen",
+  "cursor", "scroll", "margin", "escape", "param", "attribute", "column",
+  "row", "update", "handle", "byte", "char", "void", "int", "const",
+};
+
+static const char *corpus_files[] = {
+  "terminal.c", "palvideo.c", "sdlgui.c", "ps2kbd.c", "eia_pico.c",
+  "main_pico.c", "Makefile", "README.md", "char.rom", "LICENSE",
+};
+
+
+
+static uint32_t corpus_rand(void)
+{
+  /* Xorshift32, so the streams are identical on every machine. */
+  corpus_seed ^= corpus_seed << 13;
+  corpus_seed ^= corpus_seed >> 17;
+  corpus_seed ^= corpus_seed << 5;
+  return corpus_seed;
+}
+
+
+
+static void corpus_printf(const char *format, ...)
+{
+  va_list args;
+
+  va_start(args, format);
+  vfprintf(corpus_out, format, args);
+  va_end(args);
+}
+
+
+
+static const char *corpus_word(void)
+{
+  return corpus_words[corpus_rand() %
+    (sizeof(corpus_words) / sizeof(corpus_words[0]))];
+}
+
+static const char *corpus_file(void)
+{
+  return corpus_files[corpus_rand() %
+    (sizeof(corpus_files) / sizeof(corpus_files[0]))];
+}
+
+
+
+static void corpus_cmatrix(void)
+{
+  /* Falling columns of random characters, bold heads, erased tails. */
+  int head[80];
+
+  for (int col = 0; col < 80; col++) {
+    head[col] = -(int)(corpus_rand() % 24);
+  }
+
+  corpus_printf("\x1b[H\x1b[2J");
+  for (int frame = 0; frame < 64; frame++) {
+    for (int col = 0; col < 80; col += 2) {
+      if (head[col] >= 0 && head[col] < 24) {
+        corpus_printf("\x1b[%d;%dH\x1b[1m%c\x1b[m", head[col] + 1, col + 1,
+          0x21 + (corpus_rand() % 94));
+      }
+      if (head[col] >= 8 && head[col] < 32) {
+        corpus_printf("\x1b[%d;%dH ", head[col] - 7, col + 1);
+      }
+      head[col]++;
+      if (head[col] >= 32) {
+        head[col] = -(int)(corpus_rand() % 16);
+      }
+    }
+  }
+}
+
+
+
+static void corpus_vttest(void)
+{
+  /* Exercise the screen manipulation paths much like vttest does. */
+  corpus_printf("\x1b#8");
+  corpus_printf("\x1b[9;10H\x1b[1J\x1b[18;60H\x1b[0J\x1b[1K");
+  corpus_printf("\x1b[?3h\x1b[?7h");
+  for (int i = 0; i < 132 * 2; i++) {
+    corpus_printf("%c", 'A' + (i % 26));
+  }
+  corpus_printf("\x1b[?3l\x1b[3g\x1b[1;1H");
+  for (int col = 0; col < 80; col += 3) {
+    corpus_printf("\x1b[3C\x1bH");
+  }
+  corpus_printf("\x1b[1;1H");
+  for (int i = 0; i < 26; i++) {
+    corpus_printf("*\t");
+  }
+  corpus_printf("\x1b[5;20r\x1b[?6h");
+  for (int i = 0; i < 40; i++) {
+    corpus_printf("\x1b[16;1H%s %d\r\n", corpus_word(), i);
+    corpus_printf("\x1b[1;1H\x1bM%s", corpus_word());
+  }
+  corpus_printf("\x1b[?6l\x1b[r\x1b[?7l\x1b[H\x1b[2J");
+  corpus_printf("\x1b[1;4;5;7mVT100\x1b[m \x1b[4mUnderline\x1b[m\r\n");
+  corpus_printf("\x1b[10;10H\x1b[5A\x1b[3B\x1b[20C\x1b[4D+\x1b[2K");
+  corpus_printf("\x1b[0c\x1b[*y");
+}
+
+
+
+static void corpus_compiler(void)
+{
+  /* Mostly plain text with a little bold, like gcc diagnostics. */
+  const char *file = corpus_file();
+  int line = 1 + (corpus_rand() % 900);
+  int col = 1 + (corpus_rand() % 60);
+
+  corpus_printf("\x1b[1m%s:%d:%d: \x1b[m", file, line, col);
+  if (corpus_rand() % 3 == 0) {
+    corpus_printf("\x1b[1merror: \x1b[m");
+  } else {
+    corpus_printf("\x1b[1mwarning: \x1b[m");
+  }
+  corpus_printf("unused variable '%s' [-Wunused-variable]\r\n", corpus_word());
+  corpus_printf("  %4d |   %s %s = %s;\r\n", line,
+    corpus_word(), corpus_word(), corpus_word());
+  corpus_printf("       |   %*s\x1b[1m^~~~~\x1b[m\r\n", col % 30, "");
+}
+
+
+
+static void corpus_ls(void)
+{
+  /* Directory listings as produced by "ls -lR". */
+  corpus_printf("\r\n./%s/%s:\r\ntotal %d\r\n",
+    corpus_word(), corpus_word(), corpus_rand() % 1000);
+  for (int i = 0; i < 16; i++) {
+    corpus_printf("%s 1 pi pi %8d Feb 21  2023 %s\r\n",
+      (corpus_rand() % 4 == 0) ? "drwxr-xr-x" : "-rw-r--r--",
+      corpus_rand() % 100000, corpus_file());
+  }
+}
+
+
+
+static void corpus_editor(void)
+{
+  /* A curses editor redrawing lines and its status bar. */
+  int row = 1 + (corpus_rand() % 22);
+
+  corpus_printf("\x1b[%d;1H\x1b[K", row);
+  corpus_printf("%s(%s, %s);", corpus_word(), corpus_word(), corpus_word());
+  corpus_printf("\x1b[%dd\x1b[%dG\x1b[%dX", row, 40, 8);
+  corpus_printf("-\x1b[%db", 10 + (corpus_rand() % 20));
+  corpus_printf("\x1b[24;1H\x1b[7m -- INSERT -- %s %d,%d \x1b[K\x1b[m",
+    corpus_file(), row, 1 + (corpus_rand() % 80));
+  corpus_printf("\x1b[%d;%dH", row, 1 + (corpus_rand() % 40));
+  if (corpus_rand() % 16 == 0) {
+    corpus_printf("\x1b[2;23r\x1b[23;1H\n\x1b[r");
+  }
+}
+
+
+
+static void corpus_scroll(void)
+{
+  /* Full width lines scrolling the whole screen, vtebench style. */
+  for (int col = 0; col < 79; col++) {
+    corpus_printf("%c", 0x21 + ((col + corpus_rand()) % 94));
+  }
+  corpus_printf("\r\n");
+}
+
+
+
+static void corpus_dense(void)
+{
+  /* Every cell rewritten each frame with changing attributes. */
+  corpus_printf("\x1b[H");
+  for (int row = 0; row < 24; row++) {
+    for (int col = 0; col < 80; col++) {
+      corpus_printf("\x1b[0;%dm%c", (int[]){1, 4, 5, 7}[corpus_rand() % 4],
+        0x21 + (corpus_rand() % 94));
+    }
+    if (row < 23) {
+      corpus_printf("\r\n");
+    }
+  }
+}
+
+
+
+static void corpus_reset(void)
+{
+  /* RIS in the middle of output, the cursor moved away straight after. */
+  corpus_printf("\x1b[5;7m%s\x1b[m %s\r\n", corpus_word(), corpus_word());
+  corpus_printf("\x1b" "c\x1b[%dC\x1b[%d;%dH%s", 1 + (corpus_rand() % 70),
+    2 + (corpus_rand() % 23), 1 + (corpus_rand() % 70), corpus_word());
+}
+
+
+
+static void corpus_wrap(void)
+{
+  /* Lines wrapping at the bottom of a scrolling region, literally and
+     with REP, and scrolls of any count. */
+  int top = 1 + (corpus_rand() % 12);
+  int bottom = top + 1 + (corpus_rand() % (24 - top));
+
+  corpus_printf("\x1b[?7h\x1b[%d;%dr\x1b[%d;%dH", top, bottom, bottom,
+    1 + (corpus_rand() % 80));
+  for (int i = corpus_rand() % 100; i > 0; i--) {
+    corpus_printf("%c", 0x21 + (corpus_rand() % 94));
+  }
+  corpus_printf("%s\x1b[%db", corpus_word(), corpus_rand() % 200);
+  corpus_printf("\x1b[%d%c", corpus_rand() % 30,
+    (corpus_rand() & 0x1) ? 'S' : 'T');
+  if (corpus_rand() % 8 == 0) {
+    corpus_printf("\x1b[r\x1b[24;75H%s %s", corpus_word(), corpus_word());
+  }
+}
+
+
+
+static void corpus_frames(void)
+{
+  /* A "terminominal-host" session, started with RIS like the host does. */
+  uint8_t frame[64];
+  int len = 0, count;
+  const char *word;
+
+  if (corpus_rand() % 16 == 0) {
+    corpus_printf("\x1b" "c");
+  }
+
+  frame[len++] = DIFFFRAME_OP_GOTO;
+  frame[len++] = 1 + (corpus_rand() % 23); /* Rows 17 and 19 are escaped. */
+  frame[len++] = corpus_rand() % 40;
+  frame[len++] = DIFFFRAME_OP_ATTRIBUTE;
+  frame[len++] = (int[]){0x00, 0x02, 0x04, 0x08, 0x10}[corpus_rand() % 5];
+  word = corpus_word();
+  frame[len++] = DIFFFRAME_OP_CELLS;
+  frame[len++] = strlen(word);
+  for (const char *p = word; *p != '\0'; p++) {
+    frame[len++] = *p;
+  }
+  count = 1 + (corpus_rand() % 30);
+  frame[len++] = DIFFFRAME_OP_REPEAT;
+  frame[len++] = count;
+  frame[len++] = '-';
+  frame[len++] = DIFFFRAME_OP_CURSOR;
+  frame[len++] = 1 + (corpus_rand() % 23);
+  frame[len++] = corpus_rand() % 80;
+
+  /* Now and then a frame that does not add up, and is not applied. */
+  corpus_printf("\x1b[?%d;%d;%dz", DIFFFRAME_CODE, len,
+    diffframe_sum(frame, len) + ((corpus_rand() % 32 == 0) ? 1 : 0));
+  for (int i = 0; i < len; i++) {
+    if (diffframe_escaped(frame[i])) {
+      corpus_printf("%c%c", DIFFFRAME_ESCAPE, frame[i] ^ DIFFFRAME_ESCAPE_XOR);
+    } else {
+      corpus_printf("%c", frame[i]);
+    }
+  }
+}
+
+
+
+static void corpus_adversarial(void)
+{
+  /* Worst cases for a single byte, mixed at random. */
+  int top, bottom;
+
+  switch (corpus_rand() % 9) {
+  case 0: /* Long and too many parameters. */
+    corpus_printf("\x1b[");
+    for (int i = 0; i < 64; i++) {
+      corpus_printf("%u;", corpus_rand());
+    }
+    corpus_printf("m");
+    break;
+
+  case 1: /* HT from the last column with no tab stops left. */
+    corpus_printf("\x1b[?3h\x1b[3g\x1b[%d;131H\t\t\t\t",
+      1 + (corpus_rand() % 24));
+    break;
+
+  case 2: /* DECALN rewrites every cell. */
+    corpus_printf("\x1b#8\x1b#8");
+    break;
+
+  case 3: /* Full screen erase, in both column modes. */
+    corpus_printf("\x1b[?3%c\x1b[2J\x1b[H\x1b[J",
+      (corpus_rand() & 0x1) ? 'h' : 'l');
+    break;
+
+  case 4: /* Scroll region thrashing. */
+    top = 1 + (corpus_rand() % 23);
+    bottom = top + 1 + (corpus_rand() % (24 - top));
+    corpus_printf("\x1b[%d;%dr\x1b[%dH\n\n\x1b[%dH\x1bM\x1bM",
+      top, bottom, bottom, top);
+    break;
+
+  case 5: /* Maximum repeat, erase and scroll counts. */
+    corpus_printf("%c\x1b[65535b\x1b[65535X\x1b[999S\x1b[999T",
+      0x21 + (corpus_rand() % 94));
+    break;
+
+  case 6: /* Checksum of the whole screen. */
+    corpus_printf("\x1b[1;1;1;24;132*y");
+    break;
+
+  case 7: /* Full width lines of wide text at the bottom of the screen. */
+    corpus_printf("\x1b[r\x1b[24H");
+    for (int i = 0; i < 140; i++) {
+      corpus_printf("%c", 0x21 + (corpus_rand() % 94));
+    }
+    corpus_printf("\r\n");
+    break;
+
+  case 8: /* Attribute churn on a blinking reverse screen. */
+    corpus_printf("\x1b[5;7m\x1b[2J\x1b[m\x1b[%dH", 1 + (corpus_rand() % 24));
+    break;
+  }
+}
+
+
+
+static corpus_scenario_t corpus_scenarios[] = {
+  { "cmatrix.vt",  corpus_cmatrix  },
+  { "vttest.vt",   corpus_vttest   },
+  { "compiler.vt", corpus_compiler },
+  { "ls-lR.vt",    corpus_ls       },
+  { "editor.vt",   corpus_editor   },
+  { "scroll.vt",   corpus_scroll   },
+  { "dense.vt",    corpus_dense    },
+  { "reset.vt",    corpus_reset    },
+  { "frames.vt",   corpus_frames   },
+  { "wrap.vt",     corpus_wrap     },
+  { "adversarial.vt", corpus_adversarial },
+};
+
+
+
+static int corpus_write(const char *dir, corpus_scenario_t *scenario,
+  long size, uint32_t seed)
+{
+  char path[CORPUS_PATH_LEN];
+
+  if (seed != 0) {
+    snprintf(path, CORPUS_PATH_LEN, "%s/%.*s-%u.vt", dir,
+      (int)(strlen(scenario->name) - 3), scenario->name, seed);
+  } else {
+    snprintf(path, CORPUS_PATH_LEN, "%s/%s", dir, scenario->name);
+  }
+  corpus_out = fopen(path, "wb");
+  if (corpus_out == NULL) {
+    fprintf(stderr, "Unable to open for writing: %s\n", path);
+    return -1;
+  }
+
+  corpus_seed = 1;
+  for (const char *p = scenario->name; *p != '\0'; p++) {
+    corpus_seed = (corpus_seed * 31) + *p;
+  }
+  corpus_seed ^= seed;
+  if (corpus_seed == 0) {
+    corpus_seed = 1; /* Xorshift never leaves zero. */
+  }
+
+  while (ftell(corpus_out) < size) {
+    scenario->generate();
+  }
+
+  fclose(corpus_out);
+  return 0;
+}
+
+
+
+static void display_help(const char *progname)
+{
+  fprintf(stdout, "Usage: %s <options> <directory>\n", progname);
+  fprintf(stdout, "Options:\n"
+     "  -h        Display this help.\n"
+     "  -s BYTES  Approximate size of each stream.\n"
+     "  -a SEED   Only the adversarial stream, named with its SEED.\n"
+     "\n");
+}
+
+
+
+int main(int argc, char *argv[])
+{
+  int c;
+  long size = CORPUS_SIZE_DEFAULT;
+  uint32_t seed = 0;
+  size_t count = sizeof(corpus_scenarios) / sizeof(corpus_scenarios[0]);
+  size_t first = 0;
+
+  while ((c = getopt(argc, argv, "hs:a:")) != -1) {
+    switch (c) {
+    case 'h':
+      display_help(argv[0]);
+      return EXIT_SUCCESS;
+
+    case 's':
+      size = atol(optarg);
+      break;
+
+    case 'a':
+      seed = strtoul(optarg, NULL, 0);
+      first = count - 1; /* The adversarial scenario is last. */
+      break;
+
+    case '?':
+    default:
+      display_help(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (optind >= argc) {
+    display_help(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  for (size_t i = first; i < count; i++) {
+    if (corpus_write(argv[optind], &corpus_scenarios[i], size, seed) != 0) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+
+
@@ -0,0 +1,81 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "diag.h"
+#include "eia.h"
+
+#define DIAG_REPORT_MAX 8
+#define DIAG_LINE_LEN 80
+
+typedef struct diag_entry_s {
+  int code;
+  const char *name;
+  diag_report_t report;
+} diag_entry_t;
+
+static diag_entry_t diag_entry[DIAG_REPORT_MAX];
+static int diag_entry_count = 0;
+
+
+
+void diag_register(int code, const char *name, diag_report_t report)
+{
+  if (diag_entry_count >= DIAG_REPORT_MAX) {
+    return;
+  }
+  diag_entry[diag_entry_count].code = code;
+  diag_entry[diag_entry_count].name = name;
+  diag_entry[diag_entry_count].report = report;
+  diag_entry_count++;
+}
+
+
+
+void diag_printf(diag_put_t put, const char *format, ...)
+{
+  va_list args;
+  char line[DIAG_LINE_LEN];
+
+  va_start(args, format);
+  vsnprintf(line, DIAG_LINE_LEN, format, args);
+  va_end(args);
+
+  for (char *p = line; *p != '\0'; p++) {
+    put(*p);
+  }
+}
+
+
+
+static void diag_send(uint8_t c)
+{
+  eia_send(c);
+}
+
+
+
+void diag_request(int code)
+{
+  /* Reply as a device control string: ESC P <code> ; <report> ESC \ */
+  for (int i = 0; i < diag_entry_count; i++) {
+    if (diag_entry[i].code == code) {
+      diag_printf(diag_send, "\x1bP%d;", code);
+      diag_entry[i].report(diag_send);
+      diag_printf(diag_send, "\x1b\\");
+      return;
+    }
+  }
+}
+
+
+
+void diag_dump(diag_put_t put)
+{
+  for (int i = 0; i < diag_entry_count; i++) {
+    diag_printf(put, "[%s]\n", diag_entry[i].name);
+    diag_entry[i].report(put);
+  }
+}
+
+
+
@@ -0,0 +1,16 @@
+#ifndef _DIAG_H
+#define _DIAG_H
+
+#include <stdint.h>
+
+#define DIAG_STATS 900
+
+typedef void (*diag_put_t)(uint8_t c);
+typedef void (*diag_report_t)(diag_put_t put);
+
+void diag_register(int code, const char *name, diag_report_t report);
+void diag_request(int code);
+void diag_dump(diag_put_t put);
+void diag_printf(diag_put_t put, const char *format, ...);
+
+#endif /* _DIAG_H */
@@ -0,0 +1,58 @@
+#ifndef _DIFFFRAME_H
+#define _DIFFFRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Screen difference frames, sent by "terminominal-host" instead of the
+   output of the program it runs, once the terminal has said it takes them.
+
+   The host asks with "CSI ? 910 n" and the terminal answers
+   "CSI ? 910 ; 2 n", the 2 being the version. A frame is introduced with
+   "CSI ? 910 ; LEN ; SUM z" and followed by LEN bytes of operations, with
+   SUM the Fletcher-16 of those bytes. A frame that does not add up is not
+   applied, and the terminal answers "CSI ? 910 ; 0 n" so the host sends
+   the whole screen again.
+
+   On the line, DLE, DC1, DC3 and ESC in the operations are sent as DLE
+   followed by the byte XOR 0x40, so software flow control does not take
+   them. LEN and SUM are of the operations before this escaping.
+
+   Operations, with rows and columns counted from 0:
+     GOTO row col      Where the following cells are written.
+     ATTRIBUTE attr    Attribute of the following cells.
+     REPEAT count byte The same byte in count cells.
+     CELLS count bytes Count cells, one byte each.
+     CURSOR row col    Cursor position, sent last.
+   Cells wrap to the start of the next row after the last column. */
+#define DIFFFRAME_CODE 910
+#define DIFFFRAME_VERSION 2
+#define DIFFFRAME_SIZE 1024 /* Largest LEN. */
+
+#define DIFFFRAME_ESCAPE 0x10 /* DLE */
+#define DIFFFRAME_ESCAPE_XOR 0x40
+
+#define DIFFFRAME_OP_GOTO      0x01
+#define DIFFFRAME_OP_ATTRIBUTE 0x02
+#define DIFFFRAME_OP_REPEAT    0x03
+#define DIFFFRAME_OP_CELLS     0x04
+#define DIFFFRAME_OP_CURSOR    0x05
+
+static inline bool diffframe_escaped(uint8_t byte)
+{
+  return (byte == 0x10 || byte == 0x11 || byte == 0x13 || byte == 0x1B);
+}
+
+static inline uint16_t diffframe_sum(const uint8_t *data, size_t len)
+{
+  uint16_t a = 0, b = 0;
+
+  for (size_t i = 0; i < len; i++) {
+    a = (a + data[i]) % 255;
+    b = (b + a) % 255;
+  }
+  return (b << 8) | a;
+}
+
+#endif /* _DIFFFRAME_H */
@@ -2,8 +2,22 @@
 #define _EIA_H
 
 #include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+  EIA_FLOW_NONE,
+  EIA_FLOW_XON_XOFF,
+  EIA_FLOW_RTS_CTS,
+} eia_flow_t;
+
+#define EIA_DEVICE_DEFAULT "/dev/ttyS2" /* Linux only. */
+#define EIA_BAUD_DEFAULT 115200
 
 void eia_init(void);
+int eia_init_tty(const char *device, long baud, eia_flow_t flow); /* Linux only. */
+int eia_flow_parse(const char *name); /* Linux only. */
+void eia_init_fd(int fd); /* Linux only. */
+bool eia_connected(void); /* Linux only. */
 void eia_send(uint8_t c);
 void eia_update(void);
 
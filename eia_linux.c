@@ -1,73 +1,221 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include <termios.h>
 #include <errno.h>
 #include <unistd.h>
+#include <poll.h>
 #include <sys/ioctl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
-#include <ctype.h>
+#include <linux/serial.h>
+#include "eia.h"
 #include "terminal.h"
+#include "stats.h"
+#include "trace.h"
+#include "record.h"
+#include "latency.h"
+
+#define TTY_OVERRUN_INTERVAL 1024
+#define TTY_BUFFER_SIZE 4096
+#define TTY_POLL_MS 100
+
+
+
+typedef struct tty_speed_s {
+  long baud;
+  speed_t speed;
+} tty_speed_t;
+
+static int tty_fd = -1;
+static bool tty_hangup = false;
+static uint8_t tty_buffer[TTY_BUFFER_SIZE];
+static uint32_t tty_overrun_bytes = 0;
+
+static const tty_speed_t tty_speeds[] = {
+  { 1200, B1200 },
+  { 2400, B2400 },
+  { 4800, B4800 },
+  { 9600, B9600 },
+  { 19200, B19200 },
+  { 38400, B38400 },
+  { 57600, B57600 },
+  { 115200, B115200 },
+  { 230400, B230400 },
+  { 460800, B460800 },
+  { 500000, B500000 },
+  { 576000, B576000 },
+  { 921600, B921600 },
+  { 1000000, B1000000 },
+  { 1152000, B1152000 },
+  { 1500000, B1500000 },
+  { 2000000, B2000000 },
+  { 2500000, B2500000 },
+  { 3000000, B3000000 },
+  { 3500000, B3500000 },
+  { 4000000, B4000000 },
+  { 0, B0 },
+};
+
+
+
+static void eia_overruns_update(void)
+{
+  struct serial_icounter_struct icount;
+
+  if (ioctl(tty_fd, TIOCGICOUNT, &icount) == 0) {
+    if ((uint32_t)(icount.overrun + icount.buf_overrun) !=
+        stats_counter[STATS_UART_OVERRUNS]) {
+      trace(TRACE_UART_OVERRUN, 0, icount.overrun + icount.buf_overrun);
+    }
+    stats_counter[STATS_UART_OVERRUNS] = icount.overrun + icount.buf_overrun;
+  }
+}
+
 
-#define TTY_DEVICE "/dev/ttyS2"
-#define TTY_SPEED 115200
+
+static void exit_handler(void)
+{
+  if (tty_fd != -1) {
+    close(tty_fd);
+  }
+}
 
 
 
-static int tty_fd;
+void eia_init_fd(int fd)
+{
+  /* An already open stream, such as the loopback host or a PTY. */
+  tty_fd = fd;
+  atexit(exit_handler);
+}
 
 
 
-static void exit_handler(void)
+int eia_flow_parse(const char *name)
 {
-  close(tty_fd);
+  if (strcmp(name, "none") == 0) {
+    return EIA_FLOW_NONE;
+  } else if (strcmp(name, "xon") == 0) {
+    return EIA_FLOW_XON_XOFF;
+  } else if (strcmp(name, "rts") == 0) {
+    return EIA_FLOW_RTS_CTS;
+  } else {
+    fprintf(stderr, "Unknown flow control: %s\n", name);
+    return -1;
+  }
 }
 
 
 
-void eia_init(void)
+int eia_init_tty(const char *device, long baud, eia_flow_t flow)
 {
-  int result;
+  int i;
   struct termios tio;
 
-  tty_fd = open(TTY_DEVICE, O_RDWR | O_NOCTTY);
+  for (i = 0; tty_speeds[i].baud != 0; i++) {
+    if (tty_speeds[i].baud == baud) {
+      break;
+    }
+  }
+  if (tty_speeds[i].baud == 0) {
+    fprintf(stderr, "Unsupported baud rate: %ld\n", baud);
+    return -1;
+  }
+
+  tty_fd = open(device, O_RDWR | O_NOCTTY);
   if (tty_fd == -1) {
-    fprintf(stderr, "open() failed with errno: %d\n", errno);
-    exit(1);
+    fprintf(stderr, "open() of %s failed with errno: %d\n", device, errno);
+    return -1;
   }
 
   atexit(exit_handler);
 
+  if (tcgetattr(tty_fd, &tio) == -1) {
+    fprintf(stderr, "tcgetattr() failed with errno: %d\n", errno);
+    return -1;
+  }
   cfmakeraw(&tio);
-  cfsetospeed(&tio, B115200);
+  cfsetospeed(&tio, tty_speeds[i].speed);
+  cfsetispeed(&tio, tty_speeds[i].speed);
+  tio.c_cc[VMIN] = 1; /* Return as soon as anything has arrived. */
+  tio.c_cc[VTIME] = 0;
+
+  /* Done by the kernel, so writes block while the remote side has
+     stopped us, and XON/XOFF never reach the terminal. */
+  if (flow == EIA_FLOW_XON_XOFF) {
+    tio.c_iflag |= (IXON | IXOFF);
+  } else if (flow == EIA_FLOW_RTS_CTS) {
+    tio.c_cflag |= CRTSCTS;
+  }
 
-  result = ioctl(tty_fd, TCSETS, &tio);
-  if (result == -1) {
-    fprintf(stderr, "ioctl() failed with errno: %d\n", errno);
-    exit(1);
+  if (tcsetattr(tty_fd, TCSANOW, &tio) == -1) {
+    fprintf(stderr, "tcsetattr() failed with errno: %d\n", errno);
+    return -1;
   }
+  return 0;
+}
+
+
+
+bool eia_connected(void)
+{
+  return ! tty_hangup;
 }
- 
+
 
 
 void eia_send(uint8_t c)
 {
-  fprintf(stderr, ">>> 0x%02x %c\n", c, isprint(c) ? c : ' ');
+  if (tty_fd == -1) {
+    return; /* Not open when replaying a recording, or after a hangup. */
+  }
   write(tty_fd, &c, 1);
+  stats_count(STATS_TX_BYTES);
+  record_data(RECORD_OUT, &c, 1);
 }
 
 
 
 void eia_update(void)
 {
-  uint8_t c;
-  int result;
-  result = read(tty_fd, &c, 1);
-  if (result == 1) {
-    fprintf(stderr, "< 0x%02x %c\n", c, isprint(c) ? c : ' ');
-    terminal_handle_byte(c);
+  struct pollfd pfd;
+  ssize_t result;
+
+  /* Wait with a timeout, so the caller still gets to run when idle. */
+  pfd.fd = tty_fd;
+  pfd.events = POLLIN;
+  if (poll(&pfd, 1, TTY_POLL_MS) <= 0) {
+    return;
+  }
+
+  /* Everything that has arrived is taken in one read and one chunk. */
+  result = read(tty_fd, tty_buffer, TTY_BUFFER_SIZE);
+  if (result == -1 && (errno == EINTR || errno == EAGAIN)) {
+    return;
+  }
+  if (result <= 0) {
+    /* End of file, EIO when the process on a PTY has exited, or a serial
+       adapter that was unplugged. */
+    close(tty_fd);
+    tty_fd = -1;
+    tty_hangup = true;
+    return;
+  }
+  record_data(RECORD_IN, tty_buffer, result);
+  latency_rx_start();
+  terminal_handle_buffer(tty_buffer, result);
+  latency_rx_end();
+  stats_peak_update(STATS_PEAK_RX_BURST, result);
+  trace(TRACE_RX_BURST, 0, result);
+
+  /* TIOCGICOUNT is a system call, so only sample it periodically. */
+  tty_overrun_bytes += result;
+  if (tty_overrun_bytes >= TTY_OVERRUN_INTERVAL) {
+    tty_overrun_bytes = 0;
+    eia_overruns_update();
   }
 }
 
@@ -0,0 +1,24 @@
+#include <stdint.h>
+#include "eia.h"
+
+
+
+void eia_init(void)
+{
+}
+
+
+
+void eia_send(uint8_t c)
+{
+  (void)c; /* Replies to the host are discarded. */
+}
+
+
+
+void eia_update(void)
+{
+}
+
+
+
@@ -4,6 +4,11 @@
 #include "hardware/irq.h"
 #include "pico/util/queue.h"
 #include "terminal.h"
+#include "eia.h"
+#include "stats.h"
+#include "trace.h"
+#include "latency.h"
+#include "sram.h"
 
 
 
@@ -16,21 +21,43 @@ void eia_init(void)
 
   uart_set_format(uart0, 8, 1, UART_PARITY_NONE); /* 8n1 */
   uart_set_fifo_enabled(uart0, true);
+
+#ifdef UART_LOOPBACK
+  /* Internal loopback, every byte sent is echoed without a host. */
+  hw_set_bits(&uart_get_hw(uart0)->cr, UART_UARTCR_LBE_BITS);
+#endif /* UART_LOOPBACK */
 }
 
 
 
-int eia_send(uint8_t c)
+void eia_send(uint8_t c)
 {
   uart_putc(uart0, c);
+  stats_count(STATS_TX_BYTES);
 }
 
 
 
-void eia_update(void)
+void SRAM_FUNC(eia_update)(void)
 {
-  if (uart_is_readable(uart0)) {
+  int burst = 0;
+
+  if (uart_get_hw(uart0)->rsr & UART_UARTRSR_OE_BITS) {
+    stats_count(STATS_UART_OVERRUNS);
+    trace(TRACE_UART_OVERRUN, 0, 0);
+    uart_get_hw(uart0)->rsr = UART_UARTRSR_OE_BITS; /* Write to clear. */
+  }
+
+  /* Drain the FIFO, the burst length shows how full it got. */
+  while (uart_is_readable(uart0)) {
+    latency_rx_start();
     terminal_handle_byte(uart_getc(uart0));
+    latency_rx_end();
+    burst++;
+  }
+  stats_peak_update(STATS_PEAK_RX_BURST, burst);
+  if (burst > 0) {
+    trace(TRACE_RX_BURST, 0, burst);
   }
 }
 
@@ -0,0 +1,50 @@
+#include <stdint.h>
+#include "latency.h"
+#include "profile.h"
+#include "timer.h"
+
+#define LATENCY_TIMEOUT_US 1000000
+
+volatile latency_state_t latency_state = LATENCY_IDLE;
+volatile uint32_t latency_key_us;
+volatile uint32_t latency_echo_us;
+volatile uint32_t latency_applied_us;
+
+
+
+void latency_key(uint32_t key_us)
+{
+  /* A key that was never echoed is given up after a while. */
+  if (latency_state != LATENCY_IDLE &&
+      (timer_us() - latency_key_us) < LATENCY_TIMEOUT_US) {
+    return;
+  }
+  latency_key_us = key_us;
+  latency_state = LATENCY_KEY;
+}
+
+
+
+void latency_pass_start(void)
+{
+  /* The echo must be applied before the scan for this pass to show it. */
+  if (latency_state == LATENCY_APPLIED) {
+    latency_state = LATENCY_RENDERING;
+  }
+}
+
+
+
+void latency_pass_end(void)
+{
+  if (latency_state != LATENCY_RENDERING) {
+    return;
+  }
+  profile_record(PROFILE_KEY_ECHO_US, latency_echo_us - latency_key_us);
+  profile_record(PROFILE_KEY_APPLY_US, latency_applied_us - latency_key_us);
+  profile_record(PROFILE_KEY_PRESENT_US, timer_us() - latency_key_us);
+  latency_state = LATENCY_IDLE;
+}
+
+
+
@@ -0,0 +1,41 @@
+#ifndef _LATENCY_H
+#define _LATENCY_H
+
+#include <stdint.h>
+#include "timer.h"
+
+typedef enum {
+  LATENCY_IDLE,
+  LATENCY_KEY,
+  LATENCY_ECHO,
+  LATENCY_APPLIED,
+  LATENCY_RENDERING,
+} latency_state_t;
+
+/* One keypress is followed at a time, from the key to the frame. */
+extern volatile latency_state_t latency_state;
+extern volatile uint32_t latency_key_us;
+extern volatile uint32_t latency_echo_us;
+extern volatile uint32_t latency_applied_us;
+
+static inline void latency_rx_start(void)
+{
+  if (latency_state == LATENCY_KEY) {
+    latency_echo_us = timer_us();
+    latency_state = LATENCY_ECHO;
+  }
+}
+
+static inline void latency_rx_end(void)
+{
+  if (latency_state == LATENCY_ECHO) {
+    latency_applied_us = timer_us();
+    latency_state = LATENCY_APPLIED;
+  }
+}
+
+void latency_key(uint32_t key_us);
+void latency_pass_start(void);
+void latency_pass_end(void);
+
+#endif /* _LATENCY_H */
@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include "loopback.h"
+
+static int loopback_fd = -1;
+static uint32_t loopback_delay_us = 0;
+
+
+
+static void *loopback_host(void *argp)
+{
+  uint8_t c;
+
+  (void)argp;
+
+  /* Echo like a shell on a cooked tty, after the configured delay. */
+  while (read(loopback_fd, &c, 1) == 1) {
+    if (loopback_delay_us > 0) {
+      usleep(loopback_delay_us);
+    }
+    if (c == '\r' || c == '\n') {
+      write(loopback_fd, "\r\n", 2);
+    } else {
+      write(loopback_fd, &c, 1);
+    }
+  }
+
+  return NULL;
+}
+
+
+
+int loopback_open(uint32_t delay_us)
+{
+  int fds[2];
+  pthread_t tid;
+
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1) {
+    fprintf(stderr, "socketpair() failed with errno: %d\n", errno);
+    return -1;
+  }
+
+  loopback_fd = fds[1];
+  loopback_delay_us = delay_us;
+  if (pthread_create(&tid, NULL, loopback_host, NULL) != 0) {
+    fprintf(stderr, "pthread_create() failed with errno: %d\n", errno);
+    close(fds[0]);
+    close(fds[1]);
+    loopback_fd = -1;
+    return -1;
+  }
+  pthread_detach(tid);
+
+  return fds[0];
+}
+
+
+
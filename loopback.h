@@ -0,0 +1,8 @@
+#ifndef _LOOPBACK_H
+#define _LOOPBACK_H
+
+#include <stdint.h>
+
+int loopback_open(uint32_t delay_us);
+
+#endif /* _LOOPBACK_H */
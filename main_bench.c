@@ -0,0 +1,399 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <libgen.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "terminal.h"
+#include "record.h"
+#include "microbench.h"
+
+#define BENCH_ROWS 24
+#define BENCH_COLS 132
+#define BENCH_GOLDEN_MAX 64
+#define BENCH_NAME_LEN 64
+#define BENCH_WORST_MAX 8
+#define BENCH_CONTEXT_LEN 24
+
+
+
+typedef struct bench_golden_s {
+  char name[BENCH_NAME_LEN];
+  uint32_t hash;
+} bench_golden_t;
+
+typedef struct bench_worst_s {
+  size_t offset;
+  uint32_t cycles;
+} bench_worst_t;
+
+static bench_golden_t bench_golden[BENCH_GOLDEN_MAX];
+static int bench_golden_count = 0;
+static bool bench_golden_loaded = false;
+
+
+
+static uint64_t bench_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+
+
+static uint32_t bench_screen_hash(void)
+{
+  terminal_char_t c;
+  uint32_t hash = 2166136261; /* FNV-1a */
+
+  for (int row = 0; row < BENCH_ROWS; row++) {
+    for (int col = 0; col < BENCH_COLS; col++) {
+      c = terminal_char_get(row, col);
+      hash = (hash ^ c.byte) * 16777619;
+      hash = (hash ^ c.attribute) * 16777619;
+    }
+  }
+  return hash;
+}
+
+
+
+static void bench_feed(const uint8_t *data, size_t size)
+{
+  terminal_init();
+  terminal_handle_buffer(data, size);
+}
+
+
+
+static int bench_cycles_compare(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+
+
+static void bench_context_print(const uint8_t *data, size_t offset)
+{
+  size_t start = (offset >= BENCH_CONTEXT_LEN) ?
+    offset - BENCH_CONTEXT_LEN + 1 : 0;
+
+  /* The bytes leading up to and including the slow one. */
+  for (size_t i = start; i <= offset; i++) {
+    if (data[i] == 0x1B) {
+      printf("\\e");
+    } else if (data[i] >= 0x20 && data[i] < 0x7F && data[i] != '\\') {
+      putchar(data[i]);
+    } else {
+      printf("\\x%02x", data[i]);
+    }
+  }
+}
+
+
+
+static void bench_latency(const char *name, const uint8_t *data, size_t size)
+{
+  uint32_t *cycles;
+  uint64_t start;
+  bench_worst_t worst[BENCH_WORST_MAX];
+  int worst_count = 0;
+  int slot;
+
+  cycles = malloc(size * sizeof(uint32_t));
+  if (cycles == NULL) {
+    fprintf(stderr, "Out of memory\n");
+    return;
+  }
+
+  /* Every byte timed on its own, the worst kept with their offsets. */
+  terminal_init();
+  for (size_t i = 0; i < size; i++) {
+    start = microbench_cycles();
+    terminal_handle_byte(data[i]);
+    cycles[i] = microbench_cycles() - start;
+
+    if (worst_count < BENCH_WORST_MAX) {
+      slot = worst_count++;
+    } else {
+      slot = 0;
+      for (int j = 1; j < BENCH_WORST_MAX; j++) {
+        if (worst[j].cycles < worst[slot].cycles) {
+          slot = j;
+        }
+      }
+      if (cycles[i] <= worst[slot].cycles) {
+        continue;
+      }
+    }
+    worst[slot].offset = i;
+    worst[slot].cycles = cycles[i];
+  }
+
+  for (int i = 0; i < worst_count; i++) {
+    for (int j = i + 1; j < worst_count; j++) {
+      if (worst[j].cycles > worst[i].cycles) {
+        bench_worst_t swap = worst[i];
+        worst[i] = worst[j];
+        worst[j] = swap;
+      }
+    }
+  }
+
+  qsort(cycles, size, sizeof(uint32_t), bench_cycles_compare);
+  printf("%-16s %10lld %10u %10u %10u %10u %10u\n", name, (long long)size,
+    cycles[size / 2], cycles[(size * 99) / 100], cycles[(size * 999) / 1000],
+    cycles[(size * 9999) / 10000], cycles[size - 1]);
+  for (int i = 0; i < worst_count; i++) {
+    printf("  %10u cycles at %-10zu ", worst[i].cycles, worst[i].offset);
+    bench_context_print(data, worst[i].offset);
+    printf("\n");
+  }
+
+  free(cycles);
+}
+
+
+
+static int bench_golden_load(const char *path)
+{
+  FILE *fh;
+  char name[BENCH_NAME_LEN];
+  unsigned int hash;
+
+  fh = fopen(path, "r");
+  if (fh == NULL) {
+    fprintf(stderr, "Unable to open golden file: %s\n", path);
+    return -1;
+  }
+
+  while (fscanf(fh, "%63s %x", name, &hash) == 2) {
+    if (bench_golden_count >= BENCH_GOLDEN_MAX) {
+      break;
+    }
+    strcpy(bench_golden[bench_golden_count].name, name);
+    bench_golden[bench_golden_count].hash = hash;
+    bench_golden_count++;
+  }
+
+  fclose(fh);
+  bench_golden_loaded = true;
+  return 0;
+}
+
+
+
+static bench_golden_t *bench_golden_find(const char *name)
+{
+  for (int i = 0; i < bench_golden_count; i++) {
+    if (strcmp(bench_golden[i].name, name) == 0) {
+      return &bench_golden[i];
+    }
+  }
+  return NULL;
+}
+
+
+
+static int bench_run(const char *path, int iterations, bool print_golden,
+  bool latency)
+{
+  int fd;
+  struct stat st;
+  uint8_t *data;
+  uint8_t *stream;
+  size_t size;
+  uint32_t hash;
+  uint64_t start, elapsed;
+  bench_golden_t *golden;
+  char path_copy[PATH_MAX];
+  const char *name;
+  const char *verdict;
+  int result = 0;
+
+  fd = open(path, O_RDONLY);
+  if (fd == -1) {
+    fprintf(stderr, "open() failed on %s with errno: %d\n", path, errno);
+    return -1;
+  }
+  if (fstat(fd, &st) == -1 || st.st_size == 0) {
+    fprintf(stderr, "Empty or unreadable stream: %s\n", path);
+    close(fd);
+    return -1;
+  }
+
+  data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    fprintf(stderr, "mmap() failed on %s with errno: %d\n", path, errno);
+    return -1;
+  }
+  madvise(data, st.st_size, MADV_SEQUENTIAL | MADV_WILLNEED);
+
+  /* Session recordings are benchmarked on their host to terminal bytes. */
+  stream = data;
+  size = st.st_size;
+  if (size >= RECORD_MAGIC_LEN &&
+      memcmp(data, RECORD_MAGIC, RECORD_MAGIC_LEN) == 0) {
+    stream = malloc(st.st_size);
+    if (stream == NULL) {
+      munmap(data, st.st_size);
+      return -1;
+    }
+    size = record_extract(data, st.st_size, stream);
+    if (size == 0) {
+      fprintf(stderr, "Empty or unreadable stream: %s\n", path);
+      free(stream);
+      munmap(data, st.st_size);
+      return -1;
+    }
+  }
+
+  strncpy(path_copy, path, PATH_MAX - 1);
+  path_copy[PATH_MAX - 1] = '\0';
+  name = basename(path_copy);
+
+  if (latency) {
+    bench_feed(stream, size); /* Warm up. */
+    bench_latency(name, stream, size);
+    if (stream != data) {
+      free(stream);
+    }
+    munmap(data, st.st_size);
+    return 0;
+  }
+
+  /* First pass warms the caches and produces the screen hash. */
+  bench_feed(stream, size);
+  hash = bench_screen_hash();
+
+  start = bench_ns();
+  for (int i = 0; i < iterations; i++) {
+    bench_feed(stream, size);
+  }
+  elapsed = bench_ns() - start;
+
+  if (stream != data) {
+    free(stream);
+  }
+  munmap(data, st.st_size);
+
+  if (print_golden) {
+    printf("%s %08x\n", name, hash);
+    return 0;
+  }
+
+  golden = bench_golden_find(name);
+  if (golden == NULL) {
+    verdict = "----";
+    if (bench_golden_loaded) {
+      result = 1; /* A stream that is checked must have an entry. */
+    }
+  } else if (golden->hash == hash) {
+    verdict = "OK";
+  } else {
+    verdict = "FAIL";
+    result = 1;
+  }
+
+  printf("%-16s %10lld %10.2f %10.2f   %08x %s\n", name,
+    (long long)size,
+    ((double)size * iterations) / ((double)elapsed / 1000.0),
+    (double)elapsed / ((double)size * iterations),
+    hash, verdict);
+
+  return result;
+}
+
+
+
+static void display_help(const char *progname)
+{
+  fprintf(stdout, "Usage: %s <options> <stream> ...\n", progname);
+  fprintf(stdout, "Options:\n"
+     "  -h        Display this help.\n"
+     "  -n COUNT  Number of timed passes over each stream.\n"
+     "  -g FILE   Compare final screen hashes against golden FILE.\n"
+     "  -p        Print hashes in golden file format and exit.\n"
+     "  -l        Report the latency of individual bytes, in cycles.\n"
+     "\n");
+}
+
+
+
+int main(int argc, char *argv[])
+{
+  int c;
+  int iterations = 10;
+  bool print_golden = false;
+  bool latency = false;
+  int failed = 0;
+
+  while ((c = getopt(argc, argv, "hn:g:pl")) != -1) {
+    switch (c) {
+    case 'h':
+      display_help(argv[0]);
+      return EXIT_SUCCESS;
+
+    case 'n':
+      iterations = atoi(optarg);
+      if (iterations < 1) {
+        iterations = 1;
+      }
+      break;
+
+    case 'g':
+      if (bench_golden_load(optarg) != 0) {
+        return EXIT_FAILURE;
+      }
+      break;
+
+    case 'p':
+      print_golden = true;
+      break;
+
+    case 'l':
+      latency = true;
+      break;
+
+    case '?':
+    default:
+      display_help(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (optind >= argc) {
+    display_help(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  if (latency) {
+    printf("%-16s %10s %10s %10s %10s %10s %10s\n",
+      "Stream", "Bytes", "p50", "p99", "p99.9", "p99.99", "Max");
+  } else if (! print_golden) {
+    printf("%-16s %10s %10s %10s   %8s\n",
+      "Stream", "Bytes", "MB/s", "ns/byte", "Hash");
+  }
+
+  for (int i = optind; i < argc; i++) {
+    if (bench_run(argv[i], iterations, print_golden, latency) != 0) {
+      failed++;
+    }
+  }
+
+  return (failed > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+
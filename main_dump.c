@@ -0,0 +1,369 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include "terminal.h"
+#include "raster.h"
+#include "record.h"
+
+#define DUMP_ROWS 24
+#define DUMP_HEIGHT (DUMP_ROWS * RASTER_CHAR_HEIGHT)
+#define DUMP_RATE_DEFAULT 11520 /* Bytes per second at 115200 baud. */
+#define DUMP_FPS_DEFAULT 25
+#define DUMP_SNAPSHOTS_MAX 64
+#define DUMP_PATH_LEN 256
+#define DUMP_READ_CHUNK 65536
+
+
+
+static int dump_cols = 80;
+static uint32_t *dump_pixels = NULL;
+static raster_t dump_raster;
+
+static uint8_t *dump_bytes = NULL;   /* Host to terminal bytes. */
+static uint64_t *dump_times = NULL;  /* Arrival of each byte in us. */
+static size_t dump_count = 0;
+
+
+
+static inline int dump_width(void)
+{
+  return dump_cols * RASTER_CHAR_WIDTH;
+}
+
+
+
+static uint8_t *dump_read(const char *path, size_t *size)
+{
+  FILE *fh;
+  uint8_t *data = NULL;
+  uint8_t *grown;
+  size_t len = 0, got;
+
+  /* Read whole, so piped input works the same as a file. */
+  fh = (strcmp(path, "-") == 0) ? stdin : fopen(path, "rb");
+  if (fh == NULL) {
+    fprintf(stderr, "Unable to open input: %s\n", path);
+    return NULL;
+  }
+  do {
+    grown = realloc(data, len + DUMP_READ_CHUNK);
+    if (grown == NULL) {
+      fprintf(stderr, "Out of memory reading: %s\n", path);
+      free(data);
+      if (fh != stdin) {
+        fclose(fh);
+      }
+      return NULL;
+    }
+    data = grown;
+    got = fread(&data[len], 1, DUMP_READ_CHUNK, fh);
+    len += got;
+  } while (got > 0);
+  if (fh != stdin) {
+    fclose(fh);
+  }
+
+  *size = len;
+  return data;
+}
+
+
+
+static int dump_timeline(const uint8_t *data, size_t size, long rate)
+{
+  size_t pos = 0;
+  const uint8_t *chunk;
+  uint32_t delta_us;
+  record_direction_t direction;
+  uint16_t len;
+  uint64_t time_us = 0;
+
+  dump_bytes = malloc(size);
+  dump_times = malloc(size * sizeof(uint64_t));
+  if (dump_bytes == NULL || dump_times == NULL) {
+    fprintf(stderr, "Out of memory\n");
+    return -1;
+  }
+
+  if (size < RECORD_MAGIC_LEN ||
+      memcmp(data, RECORD_MAGIC, RECORD_MAGIC_LEN) != 0) {
+    /* Plain stream, paced at a fixed byte rate. */
+    for (size_t i = 0; i < size; i++) {
+      dump_bytes[i] = data[i];
+      dump_times[i] = ((uint64_t)i * 1000000) / rate;
+    }
+    dump_count = size;
+    return 0;
+  }
+
+  /* Session recording, the original timing is kept. */
+  while ((chunk = record_next(data, size, &pos, &delta_us, &direction,
+    &len)) != NULL) {
+    time_us += delta_us;
+    if (direction != RECORD_IN) {
+      continue;
+    }
+    for (uint16_t i = 0; i < len; i++) {
+      dump_bytes[dump_count] = chunk[i];
+      dump_times[dump_count] = time_us;
+      dump_count++;
+    }
+  }
+  return 0;
+}
+
+
+
+static void dump_render(uint64_t time_us)
+{
+  /* Same blink period as the SDL version, based on the stream time. */
+  dump_raster.blink_off = (((time_us / 1000) % 1000) > 500);
+
+  for (int row = 0; row < DUMP_ROWS; row++) {
+    for (int col = 0; col < dump_cols; col++) {
+      if (terminal_char_changed(row, col)) {
+        raster_char(&dump_raster, row, col, terminal_char_get(row, col));
+      }
+    }
+  }
+}
+
+
+
+static int dump_ppm_write(const char *prefix, size_t offset)
+{
+  FILE *fh;
+  char path[DUMP_PATH_LEN];
+  uint8_t level;
+
+  snprintf(path, DUMP_PATH_LEN, "%s-%zu.ppm", prefix, offset);
+  fh = fopen(path, "wb");
+  if (fh == NULL) {
+    fprintf(stderr, "Unable to open for writing: %s\n", path);
+    return -1;
+  }
+
+  fprintf(fh, "P6\n%d %d\n255\n", dump_width(), DUMP_HEIGHT);
+  for (int i = 0; i < (dump_width() * DUMP_HEIGHT); i++) {
+    level = dump_pixels[i];
+    fputc(level, fh);
+    fputc(level, fh);
+    fputc(level, fh);
+  }
+
+  fclose(fh);
+  return 0;
+}
+
+
+
+static void dump_y4m_frame(FILE *fh)
+{
+  /* Gray, so the chroma planes are constant. */
+  fprintf(fh, "FRAME\n");
+  for (int i = 0; i < (dump_width() * DUMP_HEIGHT); i++) {
+    fputc((uint8_t)dump_pixels[i], fh);
+  }
+  for (int i = 0; i < (dump_width() * DUMP_HEIGHT * 2); i++) {
+    fputc(0x80, fh);
+  }
+}
+
+
+
+static int dump_snapshots(const char *prefix, const size_t *offsets,
+  int offset_count)
+{
+  size_t next = 0;
+
+  for (int i = 0; i < offset_count; i++) {
+    for (; next < offsets[i] && next < dump_count; next++) {
+      terminal_handle_byte(dump_bytes[next]);
+    }
+    dump_render((next > 0) ? dump_times[next - 1] : 0);
+    if (dump_ppm_write(prefix, next) != 0) {
+      return -1;
+    }
+  }
+
+  for (; next < dump_count; next++) {
+    terminal_handle_byte(dump_bytes[next]);
+  }
+  dump_render((next > 0) ? dump_times[next - 1] : 0);
+  return dump_ppm_write(prefix, next);
+}
+
+
+
+static int dump_video(const char *path, int fps)
+{
+  FILE *fh;
+  size_t next = 0;
+  uint64_t frame_us = 1000000 / fps;
+  uint64_t time_us;
+  long frames = 0;
+
+  fh = fopen(path, "wb");
+  if (fh == NULL) {
+    fprintf(stderr, "Unable to open for writing: %s\n", path);
+    return -1;
+  }
+
+  fprintf(fh, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444 XCOLORRANGE=FULL\n",
+    dump_width(), DUMP_HEIGHT, fps);
+
+  /* Each frame shows every byte that arrived before it, and the last
+     frame is after the end of the stream. */
+  for (time_us = 0; ; time_us += frame_us) {
+    for (; next < dump_count && dump_times[next] <= time_us; next++) {
+      terminal_handle_byte(dump_bytes[next]);
+    }
+    dump_render(time_us);
+    dump_y4m_frame(fh);
+    frames++;
+    if (next >= dump_count) {
+      break;
+    }
+  }
+
+  fclose(fh);
+  fprintf(stderr, "%ld frames written to %s\n", frames, path);
+  return 0;
+}
+
+
+
+static int dump_offsets_parse(const char *arg, size_t *offsets)
+{
+  int count = 0;
+  char *end;
+
+  /* Byte offsets separated by commas, in increasing order. */
+  while (*arg != '\0' && count < DUMP_SNAPSHOTS_MAX) {
+    offsets[count++] = strtoul(arg, &end, 0);
+    if (end == arg) {
+      return -1;
+    }
+    arg = (*end == ',') ? end + 1 : end;
+  }
+  return count;
+}
+
+
+
+static void display_help(const char *progname)
+{
+  fprintf(stdout, "Usage: %s <options> <stream|recording|->\n", progname);
+  fprintf(stdout, "Options:\n"
+     "  -h        Display this help.\n"
+     "  -p PREFIX Write PPM snapshots named PREFIX-<offset>.ppm.\n"
+     "  -s LIST   Byte offsets to take snapshots at, the end is always taken.\n"
+     "  -y FILE   Write a Y4M video.\n"
+     "  -f FPS    Video frame rate.\n"
+     "  -b RATE   Bytes per second for plain streams, recordings keep time.\n"
+     "  -c        132 columns, starting in 132 column mode.\n"
+     "\n");
+}
+
+
+
+int main(int argc, char *argv[])
+{
+  int c;
+  char *ppm_prefix = NULL;
+  char *y4m_path = NULL;
+  size_t offsets[DUMP_SNAPSHOTS_MAX];
+  int offset_count = 0;
+  int fps = DUMP_FPS_DEFAULT;
+  long rate = DUMP_RATE_DEFAULT;
+  uint8_t *data;
+  size_t size;
+
+  while ((c = getopt(argc, argv, "hp:s:y:f:b:c")) != -1) {
+    switch (c) {
+    case 'h':
+      display_help(argv[0]);
+      return EXIT_SUCCESS;
+
+    case 'p':
+      ppm_prefix = optarg;
+      break;
+
+    case 's':
+      offset_count = dump_offsets_parse(optarg, offsets);
+      if (offset_count < 0) {
+        fprintf(stderr, "Invalid offsets: %s\n", optarg);
+        return EXIT_FAILURE;
+      }
+      break;
+
+    case 'y':
+      y4m_path = optarg;
+      break;
+
+    case 'f':
+      fps = atoi(optarg);
+      break;
+
+    case 'b':
+      rate = atol(optarg);
+      break;
+
+    case 'c':
+      dump_cols = 132;
+      break;
+
+    case '?':
+    default:
+      display_help(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (optind >= argc || (ppm_prefix == NULL) == (y4m_path == NULL) ||
+      fps < 1 || rate < 1) {
+    display_help(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  data = dump_read(argv[optind], &size);
+  if (data == NULL || dump_timeline(data, size, rate) != 0) {
+    return EXIT_FAILURE;
+  }
+  free(data);
+
+  dump_pixels = calloc(dump_width() * DUMP_HEIGHT, sizeof(uint32_t));
+  if (dump_pixels == NULL) {
+    fprintf(stderr, "Out of memory\n");
+    return EXIT_FAILURE;
+  }
+  dump_raster.pixels = dump_pixels;
+  dump_raster.pitch = dump_width();
+  dump_raster.palette[RASTER_SHADE_OFF] = RASTER_LEVEL_OFF;
+  dump_raster.palette[RASTER_SHADE_BOLD] = RASTER_LEVEL_BOLD;
+  dump_raster.palette[RASTER_SHADE_ON] = RASTER_LEVEL_ON;
+
+  terminal_init();
+  if (dump_cols == 132) {
+    /* As if the stream set it, which it may still undo. */
+    terminal_handle_buffer((const uint8_t *)"\x1b[?3h", 5);
+  }
+
+  if (ppm_prefix != NULL) {
+    if (dump_snapshots(ppm_prefix, offsets, offset_count) != 0) {
+      return EXIT_FAILURE;
+    }
+  } else {
+    if (dump_video(y4m_path, fps) != 0) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+
+
@@ -0,0 +1,599 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include "terminal.h"
+#include "eia.h"
+#include "timer.h"
+#include "pty.h"
+#include "diffframe.h"
+
+/* Runs a program on a pseudo-terminal with its own copy of the emulator,
+   and sends the terminal on standard input and output only what has
+   changed on the screen, as often as the line keeps up. Output the line
+   had no time for is never sent, which is what makes a busy screen fast
+   on a slow line. Without an answer to the query, bytes are passed
+   through unchanged. */
+
+#define HOST_ROWS 24
+#define HOST_COLS_MAX 132
+#define HOST_BUFFER_SIZE 4096
+#define HOST_QUERY_US 500000
+#define HOST_FRAME_US 20000 /* Changes within this are sent together. */
+#define HOST_QUEUED_MAX 64 /* Line bytes still unsent before the next update. */
+#define HOST_HELD_US 50000 /* For a lone ESC typed on the terminal. */
+#define HOST_GAP_MAX 2 /* Unchanged cells sent again instead of a GOTO. */
+#define HOST_REPEAT_MIN 4
+#define HOST_RUN_MAX 255
+#define HOST_REPLY "\x1b[?910;"
+#define HOST_REPLY_LEN 7
+
+
+
+static int host_pty_fd = -1;
+static bool host_diff = false;
+static bool host_verbose = false;
+static uint32_t host_frame_us = HOST_FRAME_US;
+
+static struct termios host_tio_saved;
+static bool host_tio_valid = false;
+
+static char host_held[HOST_REPLY_LEN + 2];
+static int host_held_len = 0;
+static uint32_t host_held_time;
+static int host_reply = -1;
+
+static terminal_char_t host_shadow[HOST_ROWS][HOST_COLS_MAX];
+static int host_cursor_row = -1;
+static int host_cursor_col = -1;
+static int host_cols = 80;
+static uint8_t host_cursor_key_code = '[';
+static bool host_crlf = false;
+static bool host_bracketed_paste = false;
+
+static uint8_t host_frame[DIFFFRAME_SIZE];
+static int host_frame_len = 0;
+static int host_frame_row = -1; /* Where the terminal writes next. */
+static int host_frame_col = -1;
+static int host_frame_attribute = 0;
+
+static uint64_t host_program_bytes = 0;
+static uint64_t host_line_bytes = 0;
+static uint32_t host_frames = 0;
+static uint32_t host_resends = 0;
+
+
+
+void eia_send(uint8_t c)
+{
+  /* Answers from the copy of the emulator go back to the program, but
+     only when the terminal is not also seeing the queries. */
+  if (host_diff) {
+    write(host_pty_fd, &c, 1);
+  }
+}
+
+
+
+static void host_write(int fd, const void *data, size_t len)
+{
+  const uint8_t *p = data;
+  ssize_t result;
+
+  while (len > 0) {
+    result = write(fd, p, len);
+    if (result == -1) {
+      if (errno == EINTR || errno == EAGAIN) {
+        continue;
+      }
+      return;
+    }
+    p += result;
+    len -= result;
+  }
+}
+
+
+
+static void host_line_write(const void *data, size_t len)
+{
+  host_write(STDOUT_FILENO, data, len);
+  host_line_bytes += len;
+}
+
+
+
+static void host_held_flush(void)
+{
+  host_write(host_pty_fd, host_held, host_held_len);
+  host_held_len = 0;
+}
+
+
+
+static void host_line_byte(uint8_t c)
+{
+  bool fits;
+
+  /* Answers to the query are taken out of what is typed. */
+  if (host_held_len < HOST_REPLY_LEN) {
+    fits = (c == (uint8_t)HOST_REPLY[host_held_len]);
+  } else if (host_held_len == HOST_REPLY_LEN) {
+    fits = (c >= '0' && c <= '9');
+  } else {
+    fits = (c == 'n');
+  }
+
+  if (! fits) {
+    host_held_flush();
+    if (c == (uint8_t)HOST_REPLY[0]) {
+      host_held[host_held_len++] = c;
+      host_held_time = timer_us();
+    } else {
+      host_write(host_pty_fd, &c, 1);
+    }
+    return;
+  }
+
+  if (host_held_len == 0) {
+    host_held_time = timer_us();
+  }
+  host_held[host_held_len++] = c;
+  if (host_held_len == HOST_REPLY_LEN + 2) {
+    host_reply = host_held[HOST_REPLY_LEN] - '0';
+    host_held_len = 0;
+  }
+}
+
+
+
+static void host_shadow_reset(uint8_t byte, uint8_t attribute)
+{
+  for (int row = 0; row < HOST_ROWS; row++) {
+    for (int col = 0; col < HOST_COLS_MAX; col++) {
+      host_shadow[row][col].byte = byte;
+      host_shadow[row][col].attribute = attribute;
+    }
+  }
+}
+
+
+
+static void host_frame_flush(void)
+{
+  char header[32];
+  uint8_t escaped[DIFFFRAME_SIZE * 2];
+  int len;
+
+  if (host_frame_len == 0) {
+    return;
+  }
+  len = snprintf(header, sizeof(header), "\x1b[?%d;%d;%dz", DIFFFRAME_CODE,
+    host_frame_len, diffframe_sum(host_frame, host_frame_len));
+  host_line_write(header, len);
+
+  /* Nothing for XON/XOFF flow control to take on the way. */
+  len = 0;
+  for (int i = 0; i < host_frame_len; i++) {
+    if (diffframe_escaped(host_frame[i])) {
+      escaped[len++] = DIFFFRAME_ESCAPE;
+      escaped[len++] = host_frame[i] ^ DIFFFRAME_ESCAPE_XOR;
+    } else {
+      escaped[len++] = host_frame[i];
+    }
+  }
+  host_line_write(escaped, len);
+  host_frames++;
+
+  /* Every frame starts over at the terminal. */
+  host_frame_len = 0;
+  host_frame_row = -1;
+  host_frame_col = -1;
+  host_frame_attribute = 0;
+}
+
+
+
+static void host_frame_cells(int row, int col, const terminal_char_t *cells,
+  int count, bool repeat)
+{
+  /* Room for a GOTO, an ATTRIBUTE and the cells. */
+  if ((host_frame_len + 7 + ((repeat) ? 1 : count)) > DIFFFRAME_SIZE) {
+    host_frame_flush();
+  }
+
+  if (row != host_frame_row || col != host_frame_col) {
+    host_frame[host_frame_len++] = DIFFFRAME_OP_GOTO;
+    host_frame[host_frame_len++] = row;
+    host_frame[host_frame_len++] = col;
+  }
+  if (cells[0].attribute != host_frame_attribute) {
+    host_frame[host_frame_len++] = DIFFFRAME_OP_ATTRIBUTE;
+    host_frame[host_frame_len++] = cells[0].attribute;
+    host_frame_attribute = cells[0].attribute;
+  }
+
+  if (repeat) {
+    host_frame[host_frame_len++] = DIFFFRAME_OP_REPEAT;
+    host_frame[host_frame_len++] = count;
+    host_frame[host_frame_len++] = cells[0].byte;
+  } else {
+    host_frame[host_frame_len++] = DIFFFRAME_OP_CELLS;
+    host_frame[host_frame_len++] = count;
+    for (int i = 0; i < count; i++) {
+      host_frame[host_frame_len++] = cells[i].byte;
+    }
+  }
+
+  /* The terminal wraps to the next row after the last column. */
+  col += count;
+  host_frame_row = row + (col / host_cols);
+  host_frame_col = col % host_cols;
+}
+
+
+
+static inline bool host_same(terminal_char_t a, terminal_char_t b)
+{
+  return (a.byte == b.byte && a.attribute == b.attribute);
+}
+
+
+
+static int host_repeat(const terminal_char_t *line, int from, int end)
+{
+  int run = 1;
+
+  while ((from + run) < end && run < HOST_RUN_MAX &&
+         host_same(line[from + run], line[from])) {
+    run++;
+  }
+  return run;
+}
+
+
+
+static void host_row_encode(int row)
+{
+  terminal_char_t line[HOST_COLS_MAX];
+  int col, end, i, run;
+
+  for (col = 0; col < host_cols; col++) {
+    line[col] = terminal_char_plain(row, col);
+  }
+
+  col = 0;
+  while (col < host_cols) {
+    if (host_same(line[col], host_shadow[row][col])) {
+      col++;
+      continue;
+    }
+
+    /* A changed span, taking in short unchanged gaps. */
+    end = col + 1;
+    for (i = col + 1; i < host_cols && (i - end) < HOST_GAP_MAX; i++) {
+      if (! host_same(line[i], host_shadow[row][i])) {
+        end = i + 1;
+      }
+    }
+
+    /* Runs of one cell as REPEAT, the rest as CELLS of one attribute. */
+    for (i = col; i < end; ) {
+      run = host_repeat(line, i, end);
+      if (run >= HOST_REPEAT_MIN) {
+        host_frame_cells(row, i, &line[i], run, true);
+        i += run;
+        continue;
+      }
+      run = 1;
+      while ((i + run) < end && run < HOST_RUN_MAX &&
+             line[i + run].attribute == line[i].attribute &&
+             host_repeat(line, i + run, end) < HOST_REPEAT_MIN) {
+        run++;
+      }
+      host_frame_cells(row, i, &line[i], run, false);
+      i += run;
+    }
+
+    for (i = col; i < end; i++) {
+      host_shadow[row][i] = line[i];
+    }
+    col = end;
+  }
+}
+
+
+
+static void host_modes_update(void)
+{
+  char sequence[16];
+  uint8_t code;
+
+  /* Modes that change what the terminal sends are passed on as they are.
+     A change of width clears the screen at both ends. */
+  if (terminal_columns() != host_cols) {
+    host_cols = terminal_columns();
+    snprintf(sequence, sizeof(sequence), "\x1b[?3%c",
+      (host_cols == 132) ? 'h' : 'l');
+    host_line_write(sequence, strlen(sequence));
+    host_shadow_reset(' ', 0);
+    host_cursor_row = 0;
+    host_cursor_col = 0;
+  }
+
+  code = terminal_cursor_key_code();
+  if (code != host_cursor_key_code) {
+    if (code == 0) {
+      host_line_write("\x1b[?2l", 5);
+    } else {
+      if (host_cursor_key_code == 0) {
+        host_line_write("\x1b<", 2);
+      }
+      host_line_write((code == 'O') ? "\x1b[?1h" : "\x1b[?1l", 5);
+    }
+    host_cursor_key_code = code;
+  }
+
+  if (terminal_send_crlf() != host_crlf) {
+    host_crlf = terminal_send_crlf();
+    host_line_write((host_crlf) ? "\x1b[20h" : "\x1b[20l", 5);
+  }
+
+  if (terminal_bracketed_paste() != host_bracketed_paste) {
+    host_bracketed_paste = terminal_bracketed_paste();
+    host_line_write((host_bracketed_paste) ? "\x1b[?2004h" : "\x1b[?2004l",
+      8);
+  }
+}
+
+
+
+static void host_update(void)
+{
+  uint8_t row, col;
+
+  host_modes_update();
+
+  for (int i = 0; i < HOST_ROWS; i++) {
+    host_row_encode(i);
+  }
+
+  /* Past the last column after printing there, shown on it. */
+  terminal_cursor_get(&row, &col);
+  if (col >= host_cols) {
+    col = host_cols - 1;
+  }
+  if (row != host_cursor_row || col != host_cursor_col) {
+    if ((host_frame_len + 3) > DIFFFRAME_SIZE) {
+      host_frame_flush();
+    }
+    host_frame[host_frame_len++] = DIFFFRAME_OP_CURSOR;
+    host_frame[host_frame_len++] = row;
+    host_frame[host_frame_len++] = col;
+    host_cursor_row = row;
+    host_cursor_col = col;
+  }
+  host_frame_flush();
+}
+
+
+
+static int host_queued(void)
+{
+  int queued;
+
+  if (ioctl(STDOUT_FILENO, TIOCOUTQ, &queued) == -1) {
+    return 0; /* Not a tty, so nothing to wait for. */
+  }
+  return queued;
+}
+
+
+
+static void host_negotiate(void)
+{
+  uint8_t buffer[HOST_BUFFER_SIZE];
+  struct pollfd pfd;
+  uint32_t start;
+  ssize_t len;
+
+  /* Typing during the wait is kept for the program. */
+  host_line_write("\x1b[?910n", 7);
+  start = timer_us();
+  while (host_reply == -1 && (timer_us() - start) < HOST_QUERY_US) {
+    pfd.fd = STDIN_FILENO;
+    pfd.events = POLLIN;
+    if (poll(&pfd, 1, 10) <= 0) {
+      continue;
+    }
+    len = read(STDIN_FILENO, buffer, HOST_BUFFER_SIZE);
+    if (len <= 0) {
+      break;
+    }
+    for (ssize_t i = 0; i < len; i++) {
+      host_line_byte(buffer[i]);
+    }
+  }
+
+  if (host_reply == DIFFFRAME_VERSION) {
+    /* Both ends start from a reset, blank screen. */
+    host_diff = true;
+    host_line_write("\x1b" "c", 2);
+    terminal_init();
+    host_shadow_reset(' ', 0);
+    host_cursor_row = 0;
+    host_cursor_col = 0;
+  }
+  host_reply = -1;
+}
+
+
+
+static void host_exit_handler(void)
+{
+  if (host_tio_valid) {
+    tcsetattr(STDIN_FILENO, TCSANOW, &host_tio_saved);
+  }
+  if (host_verbose) {
+    fprintf(stderr, "%s: %llu bytes from the program, %llu on the line",
+      (host_diff) ? "Differences" : "Passed through",
+      (unsigned long long)host_program_bytes,
+      (unsigned long long)host_line_bytes);
+    if (host_diff) {
+      fprintf(stderr, " in %u frames, %u resent", host_frames, host_resends);
+    }
+    fprintf(stderr, "\r\n");
+  }
+}
+
+
+
+static int host_run(void)
+{
+  uint8_t buffer[HOST_BUFFER_SIZE];
+  struct pollfd pfd[2];
+  uint32_t last = timer_us();
+  bool changed = false;
+  ssize_t len;
+
+  while (1) {
+    pfd[0].fd = host_pty_fd;
+    pfd[0].events = POLLIN;
+    pfd[1].fd = STDIN_FILENO;
+    pfd[1].events = POLLIN;
+    poll(pfd, 2, (changed || host_held_len > 0) ? 1 : 100);
+
+    if (pfd[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+      len = read(host_pty_fd, buffer, HOST_BUFFER_SIZE);
+      if (len <= 0) {
+        break; /* EIO when the program has exited. */
+      }
+      host_program_bytes += len;
+      if (host_diff) {
+        terminal_handle_buffer(buffer, len);
+        changed = true;
+      } else {
+        host_line_write(buffer, len);
+      }
+    }
+
+    if (pfd[1].revents & POLLIN) {
+      len = read(STDIN_FILENO, buffer, HOST_BUFFER_SIZE);
+      if (len <= 0) {
+        break;
+      }
+      for (ssize_t i = 0; i < len; i++) {
+        if (host_diff) {
+          host_line_byte(buffer[i]);
+        } else {
+          host_write(host_pty_fd, &buffer[i], 1);
+        }
+      }
+    }
+
+    if (host_held_len > 0 && (timer_us() - host_held_time) > HOST_HELD_US) {
+      host_held_flush();
+    }
+    if (host_reply == 0) {
+      /* A frame was lost, so nothing the terminal shows is trusted. */
+      host_shadow_reset(0, 0xFF);
+      host_cursor_row = -1;
+      host_resends++;
+      host_reply = -1;
+      changed = true;
+    }
+
+    /* Only once the line has taken the last update. */
+    if (changed && (timer_us() - last) >= host_frame_us &&
+        host_queued() < HOST_QUEUED_MAX) {
+      host_update();
+      last = timer_us();
+      changed = false;
+    }
+  }
+
+  if (host_diff) {
+    host_update();
+  }
+  return 0;
+}
+
+
+
+static void display_help(const char *progname)
+{
+  fprintf(stdout, "Usage: %s <options> [command]\n", progname);
+  fprintf(stdout, "Options:\n"
+     "  -h        Display this help.\n"
+     "  -n        Never send differences, pass everything through.\n"
+     "  -u US     Least time between updates, %d by default.\n"
+     "  -v        Report byte counts on exit.\n"
+     "\n"
+     "Run from a session on the line to the terminal, the login shell is\n"
+     "run when no command is given.\n"
+     "\n", HOST_FRAME_US);
+}
+
+
+
+int main(int argc, char *argv[])
+{
+  int c;
+  bool negotiate = true;
+  struct termios tio;
+
+  while ((c = getopt(argc, argv, "hnu:v")) != -1) {
+    switch (c) {
+    case 'h':
+      display_help(argv[0]);
+      return EXIT_SUCCESS;
+
+    case 'n':
+      negotiate = false;
+      break;
+
+    case 'u':
+      host_frame_us = atol(optarg);
+      break;
+
+    case 'v':
+      host_verbose = true;
+      break;
+
+    case '?':
+    default:
+      display_help(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (tcgetattr(STDIN_FILENO, &host_tio_saved) == 0) {
+    host_tio_valid = true;
+    tio = host_tio_saved;
+    cfmakeraw(&tio);
+    tcsetattr(STDIN_FILENO, TCSANOW, &tio);
+  }
+  atexit(host_exit_handler);
+
+  /* The program's first output waits on the pseudo-terminal until the
+     terminal has answered or not. */
+  host_pty_fd = pty_open((optind < argc) ? argv[optind] : NULL);
+  if (host_pty_fd == -1) {
+    return EXIT_FAILURE;
+  }
+  terminal_init();
+  if (negotiate) {
+    host_negotiate();
+  }
+
+  return (host_run() == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+
@@ -3,6 +3,12 @@
 #include "ps2kbd.h"
 #include "terminal.h"
 #include "eia.h"
+#include "diag.h"
+#include "stats.h"
+#include "trace.h"
+#include "profile.h"
+#include "memstat.h"
+#include "xipstat.h"
 #include "pico/stdlib.h"
 #include "pico/multicore.h"
 
@@ -20,11 +26,25 @@ int main(void)
   palvideo_init();
   ps2kbd_init();
 
+  diag_register(DIAG_STATS, "stats", stats_report);
+  diag_register(DIAG_TRACE, "trace", trace_report);
+  trace_enabled = true; /* Always kept on the terminal itself. */
+  diag_register(DIAG_PROFILE, "profile", profile_report);
+  diag_register(DIAG_MEMSTAT, "memstat", memstat_report);
+  diag_register(DIAG_XIP, "xip", xipstat_report);
+
+  xipstat_boot_benchmark();
+
   multicore_reset_core1();
+  memstat_init();
   multicore_launch_core1(main_core1);
 
   while (1) {
     eia_update();
+    if (trace_dump_requested) {
+      trace_dump_requested = false;
+      diag_request(DIAG_TRACE);
+    }
   }
 
   return 0;
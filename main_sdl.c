@@ -1,32 +1,77 @@
+#include <stdlib.h>
+#include <stdio.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <pthread.h>
+#include <unistd.h>
 #include "sdlgui.h"
 #include "terminal.h"
-#include "eia.h"
+#include "trace.h"
+#include "shmexport.h"
+#include "paste.h"
+#include "session.h"
 
 void *main_two(void *argp)
 {
   (void)argp;
   while (1) {
     sdlgui_update();
+    shmexport_update();
+    if (trace_dump_requested) {
+      trace_dump_requested = false;
+      trace_report(session_put_stderr);
+    }
   }
   return NULL;
 }
 
-int main(void)
+static void display_help(const char *progname)
 {
+  fprintf(stdout, "Usage: %s <options>\n", progname);
+  fprintf(stdout, "Options:\n"
+     "  -h        Display this help.\n");
+  session_help();
+  fprintf(stdout, "\n"
+     "Shift+Insert pastes the clipboard, paced to the baud rate.\n"
+     "Print Screen dumps the event trace.\n"
+     "\n");
+}
+
+
+
+int main(int argc, char *argv[])
+{
+  int c;
   pthread_t tid;
+  session_t session;
+
+  session_defaults(&session);
+  while ((c = getopt(argc, argv, "h" SESSION_OPTIONS)) != -1) {
+    switch (c) {
+    case 'h':
+      display_help(argv[0]);
+      return EXIT_SUCCESS;
+
+    default:
+      if (session_option(&session, c, optarg) != 0) {
+        display_help(argv[0]);
+        return EXIT_FAILURE;
+      }
+      break;
+    }
+  }
+
+  if (session_open(&session) != 0) {
+    return EXIT_FAILURE;
+  }
 
-  eia_init();
   terminal_init();
   sdlgui_init();
-
-  pthread_create(&tid, NULL, main_two, NULL);
-  while (1) {
-    eia_update();
+  if (paste_init(session.baud) != 0) {
+    return EXIT_FAILURE;
   }
-  pthread_join(tid, NULL);
 
-  return 0;
+  pthread_create(&tid, NULL, main_two, NULL);
+  return session_run(&session);
 }
 
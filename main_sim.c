@@ -0,0 +1,335 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/uart.h"
+#include "hardware/irq.h"
+#include "hardware/dma.h"
+#include "palvideo.h"
+#include "ps2kbd.h"
+#include "terminal.h"
+#include "eia.h"
+#include "stats.h"
+
+/* Runs the firmware against the pico-sdk stand-ins in sim/, one host
+   thread doing the work of both cores in turn. */
+
+#define SIM_SCANLINES 625
+#define SIM_SECTIONS 80
+#define SIM_SAMPLES (SIM_SECTIONS * 16) /* 2 bits per sample. */
+#define SIM_FIELD_SCANLINES 312
+#define SIM_KEYS_MAX 256
+#define SIM_TX_MAX 4096
+
+
+
+typedef struct sim_pass_s {
+  uint64_t passes;
+  uint64_t words_total;
+  uint32_t words_max;
+  uint64_t instructions_total;
+  uint64_t instructions_max;
+} sim_pass_t;
+
+static uint32_t sim_frame_copy[SIM_SCANLINES][SIM_SECTIONS];
+static uint8_t sim_tx[SIM_TX_MAX];
+static int sim_tx_count = 0;
+static int sim_perf_fd = -1;
+static bool sim_verbose = false;
+static sim_pass_t sim_pass;
+
+
+
+static void sim_tx_capture(uint8_t c)
+{
+  if (sim_tx_count < SIM_TX_MAX) {
+    sim_tx[sim_tx_count++] = c;
+  }
+}
+
+
+
+static const uint32_t *sim_frame(void)
+{
+  /* Found the same way as the hardware does, through the DMA channel. */
+  return (const uint32_t *)dma_hw->ch[0].read_addr;
+}
+
+
+
+static void sim_perf_open(void)
+{
+  struct perf_event_attr attr;
+
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+
+  sim_perf_fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+  if (sim_perf_fd == -1) {
+    fprintf(stderr, "No instruction counter (errno %d), counting words only\n",
+      errno);
+  }
+}
+
+
+
+static void sim_ps2_inject(uint8_t scancode)
+{
+  uint32_t data;
+  int ones = __builtin_popcount(scancode);
+
+  /* As shifted in by ps2kbd.pio, data bits then odd parity at the top. */
+  data = ((uint32_t)scancode << 23) | ((uint32_t)((ones & 0x1) ? 0 : 1) << 31);
+  pio1->rxf[0] = data; /* The only state machine claimed on pio1. */
+  irq_sim_raise(PIO1_IRQ_0);
+}
+
+
+
+static void sim_render_pass(void)
+{
+  const uint32_t *frame = sim_frame();
+  uint32_t words = 0;
+  uint64_t instructions = 0;
+
+  memcpy(sim_frame_copy, frame, sizeof(sim_frame_copy));
+
+  if (sim_perf_fd != -1) {
+    ioctl(sim_perf_fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(sim_perf_fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+  palvideo_update();
+  if (sim_perf_fd != -1) {
+    ioctl(sim_perf_fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(sim_perf_fd, &instructions, sizeof(instructions)) !=
+        sizeof(instructions)) {
+      instructions = 0;
+    }
+  }
+
+  /* Frame buffer words written with a new value, independent of the host. */
+  for (int i = 0; i < (SIM_SCANLINES * SIM_SECTIONS); i++) {
+    if (frame[i] != (&sim_frame_copy[0][0])[i]) {
+      words++;
+    }
+  }
+
+  sim_pass.passes++;
+  sim_pass.words_total += words;
+  sim_pass.instructions_total += instructions;
+  if (words > sim_pass.words_max) {
+    sim_pass.words_max = words;
+  }
+  if (instructions > sim_pass.instructions_max) {
+    sim_pass.instructions_max = instructions;
+  }
+
+  if (sim_verbose) {
+    printf("pass %llu: %u words, %llu instructions\n",
+      (unsigned long long)sim_pass.passes, words,
+      (unsigned long long)instructions);
+  }
+}
+
+
+
+static uint32_t sim_frame_hash(void)
+{
+  const uint32_t *frame = sim_frame();
+  uint32_t hash = 2166136261; /* FNV-1a */
+
+  for (int i = 0; i < (SIM_SCANLINES * SIM_SECTIONS); i++) {
+    for (int shift = 0; shift < 32; shift += 8) {
+      hash = (hash ^ ((frame[i] >> shift) & 0xFF)) * 16777619;
+    }
+  }
+  return hash;
+}
+
+
+
+static int sim_image_write(const char *path)
+{
+  FILE *fh;
+  const uint32_t *frame = sim_frame();
+  static const uint8_t level[4] = { 0x00, 0x40, 0xA0, 0xFF };
+  uint8_t line[SIM_SAMPLES];
+  uint32_t word;
+
+  fh = fopen(path, "wb");
+  if (fh == NULL) {
+    fprintf(stderr, "Unable to open for writing: %s\n", path);
+    return -1;
+  }
+
+  /* Both fields carry the same picture, so the first is line doubled.
+     Samples are shifted out most significant first. */
+  fprintf(fh, "P5\n%d %d\n255\n", SIM_SAMPLES, SIM_FIELD_SCANLINES * 2);
+  for (int scanline = 0; scanline < SIM_FIELD_SCANLINES; scanline++) {
+    for (int section = 0; section < SIM_SECTIONS; section++) {
+      word = frame[(scanline * SIM_SECTIONS) + section];
+      for (int i = 0; i < 16; i++) {
+        line[(section * 16) + i] = level[(word >> (30 - (i * 2))) & 0x3];
+      }
+    }
+    fwrite(line, 1, SIM_SAMPLES, fh);
+    fwrite(line, 1, SIM_SAMPLES, fh);
+  }
+
+  fclose(fh);
+  return 0;
+}
+
+
+
+static int sim_keys_parse(const char *arg, uint8_t *keys)
+{
+  int count = 0;
+  char *end;
+
+  /* Hexadecimal scancodes separated by commas, e.g. "1c,f0,1c". */
+  while (*arg != '\0' && count < SIM_KEYS_MAX) {
+    keys[count++] = strtoul(arg, &end, 16);
+    if (end == arg) {
+      return -1;
+    }
+    arg = (*end == ',') ? end + 1 : end;
+  }
+  return count;
+}
+
+
+
+static void display_help(const char *progname)
+{
+  fprintf(stdout, "Usage: %s <options>\n", progname);
+  fprintf(stdout, "Options:\n"
+     "  -h        Display this help.\n"
+     "  -i FILE   Host byte stream received through the UART.\n"
+     "  -k CODES  PS/2 scancodes to inject, hexadecimal and comma separated.\n"
+     "  -o FILE   Write the decoded PAL frame as a PGM image.\n"
+     "  -v        Report every render pass.\n"
+     "\n");
+}
+
+
+
+int main(int argc, char *argv[])
+{
+  int c;
+  FILE *input = NULL;
+  char *image_path = NULL;
+  uint8_t keys[SIM_KEYS_MAX];
+  int key_count = 0;
+  int byte;
+  bool pending = true;
+
+  while ((c = getopt(argc, argv, "hi:k:o:v")) != -1) {
+    switch (c) {
+    case 'h':
+      display_help(argv[0]);
+      return EXIT_SUCCESS;
+
+    case 'i':
+      input = fopen(optarg, "rb");
+      if (input == NULL) {
+        fprintf(stderr, "Unable to open input: %s\n", optarg);
+        return EXIT_FAILURE;
+      }
+      break;
+
+    case 'k':
+      key_count = sim_keys_parse(optarg, keys);
+      if (key_count < 0) {
+        fprintf(stderr, "Invalid scancodes: %s\n", optarg);
+        return EXIT_FAILURE;
+      }
+      break;
+
+    case 'o':
+      image_path = optarg;
+      break;
+
+    case 'v':
+      sim_verbose = true;
+      break;
+
+    case '?':
+    default:
+      display_help(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  eia_init();
+  uart0->tx = sim_tx_capture;
+  terminal_init();
+  palvideo_init();
+  ps2kbd_init();
+  sim_perf_open();
+
+  for (int i = 0; i < key_count; i++) {
+    sim_ps2_inject(keys[i]);
+  }
+
+  /* A FIFO full of input for core0, then a render pass for core1. */
+  while (pending) {
+    pending = false;
+    while (input != NULL && uart0->rx_count < UART_SIM_FIFO_SIZE &&
+           (byte = fgetc(input)) != EOF) {
+      uart_sim_receive(uart0, byte);
+      pending = true;
+    }
+    eia_update();
+    sim_render_pass();
+  }
+
+  if (input != NULL) {
+    fclose(input);
+  }
+
+  printf("passes=%llu\n", (unsigned long long)sim_pass.passes);
+  printf("words_per_pass=%llu max=%u\n",
+    (unsigned long long)(sim_pass.words_total / sim_pass.passes),
+    sim_pass.words_max);
+  if (sim_perf_fd != -1) {
+    printf("instructions_per_pass=%llu max=%llu\n",
+      (unsigned long long)(sim_pass.instructions_total / sim_pass.passes),
+      (unsigned long long)sim_pass.instructions_max);
+  }
+  printf("cells_rendered=%lu\n",
+    (unsigned long)stats_counter[STATS_CELLS_RENDERED]);
+  printf("tx=");
+  for (int i = 0; i < sim_tx_count; i++) {
+    if (sim_tx[i] >= 0x20 && sim_tx[i] < 0x7F && sim_tx[i] != '\\') {
+      putchar(sim_tx[i]);
+    } else {
+      printf("\\x%02x", sim_tx[i]);
+    }
+  }
+  printf("\nframe_hash=%08x\n", sim_frame_hash());
+
+  if (image_path != NULL) {
+    if (sim_image_write(image_path) != 0) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+
+
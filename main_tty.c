@@ -0,0 +1,69 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "ttygui.h"
+#include "terminal.h"
+#include "shmexport.h"
+#include "session.h"
+
+void *main_two(void *argp)
+{
+  (void)argp;
+  while (1) {
+    ttygui_update();
+    shmexport_update();
+  }
+  return NULL;
+}
+
+static void display_help(const char *progname)
+{
+  fprintf(stdout, "Usage: %s <options>\n", progname);
+  fprintf(stdout, "Options:\n"
+     "  -h        Display this help.\n");
+  session_help();
+  fprintf(stdout, "\n"
+     "The screen is drawn in this terminal, Ctrl-] quits.\n"
+     "\n");
+}
+
+
+
+int main(int argc, char *argv[])
+{
+  int c;
+  pthread_t tid;
+  session_t session;
+
+  session_defaults(&session);
+  while ((c = getopt(argc, argv, "h" SESSION_OPTIONS)) != -1) {
+    switch (c) {
+    case 'h':
+      display_help(argv[0]);
+      return EXIT_SUCCESS;
+
+    default:
+      if (session_option(&session, c, optarg) != 0) {
+        display_help(argv[0]);
+        return EXIT_FAILURE;
+      }
+      break;
+    }
+  }
+
+  if (session_open(&session) != 0) {
+    return EXIT_FAILURE;
+  }
+
+  terminal_init();
+  if (ttygui_init() != 0) {
+    return EXIT_FAILURE;
+  }
+
+  pthread_create(&tid, NULL, main_two, NULL);
+  return session_run(&session);
+}
+
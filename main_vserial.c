@@ -0,0 +1,447 @@
+#define _GNU_SOURCE /* posix_openpt() and friends. */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include "pty.h"
+
+/* A serial line between a host and the terminal, paced at a baud rate,
+   with a receive FIFO of limited depth and injected line errors. */
+
+#define VSERIAL_QUEUE_SIZE 65536
+#define VSERIAL_BATCH_MAX 4096
+#define VSERIAL_BITS_PER_BYTE 10 /* 8n1 */
+#define VSERIAL_TICK_BYTES 16 /* Delivered together while busy. */
+#define VSERIAL_TICK_MIN_NS 20000
+#define VSERIAL_TICK_MAX_NS 1000000
+#define VSERIAL_IDLE_NS 100000000
+#define VSERIAL_PPM 1000000
+
+
+
+typedef struct vserial_line_s {
+  const char *name;
+  int from_fd;
+  int to_fd;
+  bool from_open;
+  uint8_t queue[VSERIAL_QUEUE_SIZE];
+  size_t head;
+  size_t count;
+  uint8_t held[VSERIAL_BATCH_MAX]; /* Off the wire, not yet taken. */
+  size_t held_len;
+  uint64_t wire_ns; /* When the byte now on the wire started. */
+  uint64_t bytes;
+  uint64_t dropped;
+  uint64_t errors;
+  uint64_t overruns;
+} vserial_line_t;
+
+static vserial_line_t vserial_to_terminal = { .name = "host->terminal" };
+static vserial_line_t vserial_to_host = { .name = "terminal->host" };
+
+static long vserial_baud = 115200;
+static uint64_t vserial_byte_ns;
+static uint64_t vserial_tick_ns;
+static int vserial_fifo_depth = 0; /* Unlimited. */
+static uint32_t vserial_drop_ppm = 0;
+static uint32_t vserial_error_ppm = 0;
+static uint32_t vserial_seed = 1;
+static int vserial_slave_fd = -1;
+static char *vserial_link = NULL;
+static volatile sig_atomic_t vserial_stop = 0;
+
+
+
+static uint32_t vserial_rand(void)
+{
+  /* xorshift32, so a seed always gives the same errors. */
+  vserial_seed ^= vserial_seed << 13;
+  vserial_seed ^= vserial_seed >> 17;
+  vserial_seed ^= vserial_seed << 5;
+  return vserial_seed;
+}
+
+
+
+static uint64_t vserial_now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+
+
+static void vserial_sig_handler(int sig)
+{
+  (void)sig;
+  vserial_stop = 1;
+}
+
+
+
+static int vserial_terminal_open(void)
+{
+  int fd;
+  char *path;
+  struct termios tio;
+
+  fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (fd == -1 || grantpt(fd) == -1 || unlockpt(fd) == -1) {
+    fprintf(stderr, "posix_openpt() failed with errno: %d\n", errno);
+    return -1;
+  }
+  path = ptsname(fd);
+
+  /* Held open, so the terminal can come and go without a hangup, and to
+     see how much it has not read yet. Raw until the terminal sets it. */
+  vserial_slave_fd = open(path, O_RDWR | O_NOCTTY);
+  if (vserial_slave_fd == -1) {
+    fprintf(stderr, "open() of %s failed with errno: %d\n", path, errno);
+    return -1;
+  }
+  if (tcgetattr(vserial_slave_fd, &tio) == 0) {
+    cfmakeraw(&tio);
+    tcsetattr(vserial_slave_fd, TCSANOW, &tio);
+  }
+
+  if (vserial_link != NULL) {
+    unlink(vserial_link);
+    if (symlink(path, vserial_link) == -1) {
+      fprintf(stderr, "symlink() failed with errno: %d\n", errno);
+      return -1;
+    }
+  }
+
+  fprintf(stderr, "Terminal side: %s\n", path);
+  return fd;
+}
+
+
+
+static size_t vserial_fifo_space(vserial_line_t *line, size_t wanted)
+{
+  int unread;
+
+  /* Bytes the terminal has not read yet are in its receive FIFO. */
+  if (line != &vserial_to_terminal || vserial_fifo_depth == 0) {
+    return wanted;
+  }
+  if (ioctl(vserial_slave_fd, FIONREAD, &unread) == -1) {
+    return wanted;
+  }
+  if (unread >= vserial_fifo_depth) {
+    return 0;
+  }
+  return ((size_t)(vserial_fifo_depth - unread) < wanted) ?
+    (size_t)(vserial_fifo_depth - unread) : wanted;
+}
+
+
+
+static void vserial_line_receive(vserial_line_t *line)
+{
+  uint8_t buffer[VSERIAL_BATCH_MAX];
+  size_t space, tail;
+  ssize_t result;
+
+  space = VSERIAL_QUEUE_SIZE - line->count;
+  if (space == 0) {
+    return; /* The sender waits, like on a real line. */
+  }
+
+  result = read(line->from_fd, buffer,
+    (space < VSERIAL_BATCH_MAX) ? space : VSERIAL_BATCH_MAX);
+  if (result == 0 || (result == -1 && errno == EIO)) {
+    line->from_open = false;
+    return;
+  }
+
+  /* An idle wire gives no credit, so bytes never arrive faster than the
+     line rate. */
+  if (line->count == 0 && line->wire_ns < vserial_now_ns()) {
+    line->wire_ns = vserial_now_ns();
+  }
+  for (ssize_t i = 0; i < result; i++) {
+    tail = (line->head + line->count) % VSERIAL_QUEUE_SIZE;
+    line->queue[tail] = buffer[i];
+    line->count++;
+  }
+}
+
+
+
+static bool vserial_line_deliver(vserial_line_t *line)
+{
+  ssize_t result;
+
+  /* Only what the receiving side took is gone, the rest is held and
+     the wire waits, like a line with hardware flow control. */
+  if (line->held_len == 0) {
+    return true;
+  }
+  result = write(line->to_fd, line->held, line->held_len);
+  if (result > 0) {
+    line->held_len -= result;
+    memmove(line->held, &line->held[result], line->held_len);
+  }
+  return (line->held_len == 0);
+}
+
+
+
+static void vserial_line_transmit(vserial_line_t *line, uint64_t now_ns)
+{
+  uint8_t batch[VSERIAL_BATCH_MAX];
+  size_t batch_len = 0;
+  size_t space;
+  uint8_t c;
+
+  if (! vserial_line_deliver(line)) {
+    line->wire_ns = now_ns; /* No credit while held back. */
+    return;
+  }
+
+  /* Each byte arrives when its stop bit is done. */
+  while (line->count > 0 && batch_len < VSERIAL_BATCH_MAX &&
+         (line->wire_ns + vserial_byte_ns) <= now_ns) {
+    line->wire_ns += vserial_byte_ns;
+    c = line->queue[line->head];
+    line->head = (line->head + 1) % VSERIAL_QUEUE_SIZE;
+    line->count--;
+    line->bytes++;
+
+    if ((vserial_rand() % VSERIAL_PPM) < vserial_drop_ppm) {
+      line->dropped++;
+      continue;
+    }
+    if ((vserial_rand() % VSERIAL_PPM) < vserial_error_ppm) {
+      c ^= 1 << (vserial_rand() % 8); /* Framing error, garbled byte. */
+      line->errors++;
+    }
+    batch[batch_len++] = c;
+  }
+  if (batch_len == 0) {
+    return;
+  }
+
+  /* What does not fit in a receive FIFO given with -f is an overrun. */
+  space = vserial_fifo_space(line, batch_len);
+  line->overruns += batch_len - space;
+  if (space == 0 || line->to_fd == -1) {
+    return;
+  }
+  memcpy(line->held, batch, space);
+  line->held_len = space;
+  vserial_line_deliver(line);
+}
+
+
+
+static void vserial_line_report(vserial_line_t *line, double seconds)
+{
+  fprintf(stderr, "%s: %llu bytes, %.0f B/s, %llu dropped, %llu errors, "
+    "%llu overruns\n", line->name, (unsigned long long)line->bytes,
+    (seconds > 0.0) ? (line->bytes / seconds) : 0.0,
+    (unsigned long long)line->dropped, (unsigned long long)line->errors,
+    (unsigned long long)line->overruns);
+}
+
+
+
+static void display_help(const char *progname)
+{
+  fprintf(stdout, "Usage: %s <options>\n", progname);
+  fprintf(stdout, "Options:\n"
+     "  -h        Display this help.\n"
+     "  -b BAUD   Line rate, 10 bits per byte.\n"
+     "  -f DEPTH  Terminal receive FIFO depth in bytes, 0 for unlimited.\n"
+     "  -D PPM    Bytes dropped per million.\n"
+     "  -E PPM    Framing errors per million, a bit of the byte is flipped.\n"
+     "  -S SEED   Seed for the dropped bytes and errors.\n"
+     "  -e CMD    Host command, run on a pseudo-terminal.\n"
+     "  -i FILE   Host stream from a file, exits once it is delivered.\n"
+     "  -l LINK   Symbolic link to the terminal side device.\n"
+     "\n"
+     "Without -e or -i the login shell is the host.\n"
+     "\n");
+}
+
+
+
+int main(int argc, char *argv[])
+{
+  int c;
+  char *command = NULL;
+  char *input_path = NULL;
+  int host_fd, terminal_fd;
+  int unread;
+  struct pollfd pfd[2];
+  struct timespec timeout;
+  struct sigaction sa;
+  uint64_t start_ns, now_ns;
+  bool busy;
+  bool read_out = false;
+
+  while ((c = getopt(argc, argv, "hb:f:D:E:S:e:i:l:")) != -1) {
+    switch (c) {
+    case 'h':
+      display_help(argv[0]);
+      return EXIT_SUCCESS;
+
+    case 'b':
+      vserial_baud = atol(optarg);
+      break;
+
+    case 'f':
+      vserial_fifo_depth = atoi(optarg);
+      break;
+
+    case 'D':
+      vserial_drop_ppm = strtoul(optarg, NULL, 0);
+      break;
+
+    case 'E':
+      vserial_error_ppm = strtoul(optarg, NULL, 0);
+      break;
+
+    case 'S':
+      vserial_seed = strtoul(optarg, NULL, 0);
+      if (vserial_seed == 0) {
+        vserial_seed = 1; /* xorshift is stuck at zero. */
+      }
+      break;
+
+    case 'e':
+      command = optarg;
+      break;
+
+    case 'i':
+      input_path = optarg;
+      break;
+
+    case 'l':
+      vserial_link = optarg;
+      break;
+
+    case '?':
+    default:
+      display_help(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (vserial_baud < 1 || vserial_fifo_depth < 0) {
+    display_help(argv[0]);
+    return EXIT_FAILURE;
+  }
+  vserial_byte_ns = (VSERIAL_BITS_PER_BYTE * 1000000000ULL) / vserial_baud;
+
+  /* Short enough that a small FIFO is not overrun by the pacing itself. */
+  vserial_tick_ns = vserial_byte_ns * VSERIAL_TICK_BYTES;
+  if (vserial_tick_ns < VSERIAL_TICK_MIN_NS) {
+    vserial_tick_ns = VSERIAL_TICK_MIN_NS;
+  } else if (vserial_tick_ns > VSERIAL_TICK_MAX_NS) {
+    vserial_tick_ns = VSERIAL_TICK_MAX_NS;
+  }
+
+  terminal_fd = vserial_terminal_open();
+  if (terminal_fd == -1) {
+    return EXIT_FAILURE;
+  }
+  if (input_path != NULL) {
+    host_fd = open(input_path, O_RDONLY);
+    if (host_fd == -1) {
+      fprintf(stderr, "Unable to open input: %s\n", input_path);
+      return EXIT_FAILURE;
+    }
+  } else {
+    host_fd = pty_open(command);
+    if (host_fd == -1) {
+      return EXIT_FAILURE;
+    }
+  }
+  fcntl(terminal_fd, F_SETFL, fcntl(terminal_fd, F_GETFL) | O_NONBLOCK);
+
+  vserial_to_terminal.from_fd = host_fd;
+  vserial_to_terminal.to_fd = terminal_fd;
+  vserial_to_terminal.from_open = true;
+  vserial_to_host.from_fd = terminal_fd;
+  vserial_to_host.to_fd = (input_path != NULL) ? -1 : host_fd;
+  vserial_to_host.from_open = true;
+
+  sa.sa_handler = vserial_sig_handler;
+  sigemptyset(&sa.sa_mask);
+  sa.sa_flags = 0;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+
+  start_ns = vserial_now_ns();
+  while (! vserial_stop) {
+    /* Only read while there is room, the sender is held back otherwise. */
+    pfd[0].fd = (vserial_to_terminal.from_open &&
+      vserial_to_terminal.count < VSERIAL_QUEUE_SIZE) ? host_fd : -1;
+    pfd[0].events = POLLIN;
+    pfd[1].fd = (vserial_to_host.count < VSERIAL_QUEUE_SIZE) ?
+      terminal_fd : -1;
+    pfd[1].events = POLLIN;
+
+    busy = (vserial_to_terminal.count > 0 || vserial_to_host.count > 0 ||
+      vserial_to_terminal.held_len > 0 || vserial_to_host.held_len > 0);
+    timeout.tv_sec = 0;
+    timeout.tv_nsec = busy ? vserial_tick_ns : VSERIAL_IDLE_NS;
+    if (ppoll(pfd, 2, &timeout, NULL) > 0) {
+      if (pfd[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+        vserial_line_receive(&vserial_to_terminal);
+      }
+      if (pfd[1].revents & POLLIN) {
+        vserial_line_receive(&vserial_to_host);
+      }
+    }
+
+    now_ns = vserial_now_ns();
+    vserial_line_transmit(&vserial_to_terminal, now_ns);
+    vserial_line_transmit(&vserial_to_host, now_ns);
+
+    /* Done when the host has hung up, or the file has been delivered and
+       read by the terminal. */
+    if (! vserial_to_terminal.from_open && vserial_to_terminal.count == 0 &&
+        vserial_to_terminal.held_len == 0) {
+      if (input_path == NULL) {
+        break;
+      }
+      /* Twice in a row, as the last bytes written may not have reached
+         what FIONREAD counts yet. */
+      if (ioctl(vserial_slave_fd, FIONREAD, &unread) == 0 && unread == 0) {
+        if (read_out) {
+          break;
+        }
+        read_out = true;
+      } else {
+        read_out = false;
+      }
+    }
+  }
+
+  vserial_line_report(&vserial_to_terminal,
+    (vserial_now_ns() - start_ns) / 1000000000.0);
+  vserial_line_report(&vserial_to_host,
+    (vserial_now_ns() - start_ns) / 1000000000.0);
+  if (vserial_link != NULL) {
+    unlink(vserial_link);
+  }
+
+  return EXIT_SUCCESS;
+}
+
+
+
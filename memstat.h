@@ -0,0 +1,11 @@
+#ifndef _MEMSTAT_H
+#define _MEMSTAT_H
+
+#include "diag.h"
+
+#define DIAG_MEMSTAT 903
+
+void memstat_init(void);
+void memstat_report(diag_put_t put);
+
+#endif /* _MEMSTAT_H */
@@ -0,0 +1,83 @@
+#include <stdint.h>
+#include <malloc.h>
+#include "hardware/regs/addressmap.h"
+#include "memstat.h"
+#include "diag.h"
+
+#define MEMSTAT_PAINT 0xDEADBEEF
+#define MEMSTAT_SRAM_SIZE (264 * 1024)
+#define MEMSTAT_MARGIN 64 /* Words left alone below the live stack pointer. */
+
+/* Provided by the pico-sdk linker script. */
+extern uint32_t __StackBottom;
+extern uint32_t __StackTop;
+extern uint32_t __StackOneBottom;
+extern uint32_t __StackOneTop;
+extern uint32_t __end__;
+extern uint32_t __HeapLimit;
+
+
+
+static inline uint32_t *memstat_sp(void)
+{
+  uint32_t *sp;
+  __asm volatile ("mov %0, sp" : "=r" (sp));
+  return sp;
+}
+
+
+
+static void memstat_paint(uint32_t *bottom, uint32_t *top)
+{
+  for (uint32_t *p = bottom; p < top; p++) {
+    *p = MEMSTAT_PAINT;
+  }
+}
+
+
+
+static uint32_t memstat_used(const uint32_t *bottom, const uint32_t *top)
+{
+  const uint32_t *p = bottom;
+
+  /* Stacks grow down, the first overwritten word from the bottom is the
+     deepest point reached. */
+  while (p < top && *p == MEMSTAT_PAINT) {
+    p++;
+  }
+  return (top - p) * sizeof(uint32_t);
+}
+
+
+
+void memstat_init(void)
+{
+  /* Must be called on core0 before core1 is launched. The part of the
+     core0 stack that is already in use is left alone. */
+  memstat_paint(&__StackBottom, memstat_sp() - MEMSTAT_MARGIN);
+  memstat_paint(&__StackOneBottom, &__StackOneTop);
+}
+
+
+
+void memstat_report(diag_put_t put)
+{
+  struct mallinfo heap = mallinfo();
+
+  diag_printf(put, "sram=%lu\n", (unsigned long)MEMSTAT_SRAM_SIZE);
+  diag_printf(put, "static=%lu\n",
+    (unsigned long)((uintptr_t)&__end__ - SRAM_BASE));
+  diag_printf(put, "heap_limit=%lu\n",
+    (unsigned long)((uintptr_t)&__HeapLimit - (uintptr_t)&__end__));
+  diag_printf(put, "heap_arena=%lu\n", (unsigned long)heap.arena);
+  diag_printf(put, "heap_used=%lu\n", (unsigned long)heap.uordblks);
+  diag_printf(put, "core0_stack=%lu/%lu\n",
+    (unsigned long)memstat_used(&__StackBottom, &__StackTop),
+    (unsigned long)((&__StackTop - &__StackBottom) * sizeof(uint32_t)));
+  diag_printf(put, "core1_stack=%lu/%lu\n",
+    (unsigned long)memstat_used(&__StackOneBottom, &__StackOneTop),
+    (unsigned long)((&__StackOneTop - &__StackOneBottom) * sizeof(uint32_t)));
+}
+
+
+
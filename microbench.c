@@ -0,0 +1,110 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include "microbench.h"
+#include "terminal.h"
+
+
+
+const microbench_mix_t microbench_mix[MICROBENCH_MIX_MAX] = {
+  { "plain",     0 },
+  { "bold",      (0x1 << TERMINAL_ATTRIBUTE_BOLD) },
+  { "underline", (0x1 << TERMINAL_ATTRIBUTE_UNDERLINE) },
+  { "blink",     (0x1 << TERMINAL_ATTRIBUTE_BLINK) },
+  { "reverse",   (0x1 << TERMINAL_ATTRIBUTE_REVERSE) },
+  { "all",       (0x1 << TERMINAL_ATTRIBUTE_BOLD) |
+                 (0x1 << TERMINAL_ATTRIBUTE_UNDERLINE) |
+                 (0x1 << TERMINAL_ATTRIBUTE_BLINK) |
+                 (0x1 << TERMINAL_ATTRIBUTE_REVERSE) },
+};
+
+
+
+void microbench_report(const char *function, const char *mix,
+  uint64_t calls, uint64_t total, uint64_t best)
+{
+  /* Best is the fastest single batch, normalized per call. */
+  printf("%-20s %-10s %10llu %12.1f %12.1f\n", function, mix,
+    (unsigned long long)calls, (double)total / calls, (double)best);
+}
+
+
+
+static void display_help(const char *progname)
+{
+  fprintf(stdout, "Usage: %s <options>\n", progname);
+  fprintf(stdout, "Options:\n"
+     "  -h  Display this help.\n"
+     "  -t  Run the terminal core benchmarks.\n"
+     "  -s  Run the SDL rasterizer benchmarks.\n"
+     "  -p  Run the PAL rasterizer benchmarks.\n"
+     "\n"
+     "All benchmarks are run if none are selected.\n"
+     "\n");
+}
+
+
+
+int main(int argc, char *argv[])
+{
+  int c;
+  bool run_terminal = false;
+  bool run_sdlgui = false;
+  bool run_palvideo = false;
+
+  while ((c = getopt(argc, argv, "htsp")) != -1) {
+    switch (c) {
+    case 'h':
+      display_help(argv[0]);
+      return EXIT_SUCCESS;
+
+    case 't':
+      run_terminal = true;
+      break;
+
+    case 's':
+      run_sdlgui = true;
+      break;
+
+    case 'p':
+      run_palvideo = true;
+      break;
+
+    case '?':
+    default:
+      display_help(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (! (run_terminal || run_sdlgui || run_palvideo)) {
+    run_terminal = true;
+    run_sdlgui = true;
+    run_palvideo = true;
+  }
+
+#if defined(__x86_64__) || defined(__i386__)
+  printf("%-20s %-10s %10s %12s %12s\n",
+    "Function", "Mix", "Calls", "Cycles/call", "Best");
+#else
+  printf("%-20s %-10s %10s %12s %12s\n",
+    "Function", "Mix", "Calls", "ns/call", "Best");
+#endif
+
+  if (run_terminal) {
+    microbench_terminal();
+  }
+  if (run_sdlgui) {
+    microbench_sdlgui();
+  }
+  if (run_palvideo) {
+    microbench_palvideo();
+  }
+
+  return EXIT_SUCCESS;
+}
+
+
+
@@ -0,0 +1,37 @@
+#ifndef _MICROBENCH_H
+#define _MICROBENCH_H
+
+#include <stdint.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define MICROBENCH_MIX_MAX 6
+
+typedef struct microbench_mix_s {
+  const char *name;
+  uint8_t attribute;
+} microbench_mix_t;
+
+extern const microbench_mix_t microbench_mix[MICROBENCH_MIX_MAX];
+
+static inline uint64_t microbench_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+#endif
+}
+
+void microbench_report(const char *function, const char *mix,
+  uint64_t calls, uint64_t total, uint64_t best);
+
+void microbench_terminal(void);
+void microbench_sdlgui(void);
+void microbench_palvideo(void);
+
+#endif /* _MICROBENCH_H */
@@ -0,0 +1,75 @@
+#include "palvideo.c"
+#include "microbench.h"
+
+/* Included directly to reach the static functions and the frame buffer of
+   the PAL backend, built against the host stand-ins in sim/. */
+
+#define MICROBENCH_ROUNDS 64
+
+
+
+static void microbench_palvideo_char(const microbench_mix_t *mix)
+{
+  terminal_char_t c;
+  uint64_t start, elapsed, total = 0, best = UINT64_MAX;
+
+  c.attribute = mix->attribute;
+
+  for (int round = 0; round < MICROBENCH_ROUNDS; round++) {
+    start = microbench_cycles();
+    for (int row = 0; row < ROW_MAX; row++) {
+      for (int col = 0; col < COL_MAX; col++) {
+        c.byte = 0x21 + (((row * 7) + col + round) % 94);
+        palvideo_char(row, col, c);
+      }
+    }
+    elapsed = microbench_cycles() - start;
+    total += elapsed;
+    best = (elapsed < best) ? elapsed : best;
+  }
+
+  microbench_report("palvideo_char", mix->name,
+    ROW_MAX * COL_MAX * MICROBENCH_ROUNDS, total, best / (ROW_MAX * COL_MAX));
+}
+
+
+
+static void microbench_palvideo_set_pixel(void)
+{
+  uint64_t start, elapsed, total = 0, best = UINT64_MAX;
+  int pixels = ROW_MAX * CHAR_HEIGHT * COL_MAX * CHAR_WIDTH;
+
+  for (int round = 0; round < MICROBENCH_ROUNDS; round++) {
+    start = microbench_cycles();
+    for (int row = 0; row < ROW_MAX; row++) {
+      for (int col = 0; col < COL_MAX; col++) {
+        for (int y = 0; y < CHAR_HEIGHT; y++) {
+          for (int x = 0; x < CHAR_WIDTH; x++) {
+            palvideo_set_pixel(row, col, y, x, (x + y + round) & 0x3);
+          }
+        }
+      }
+    }
+    elapsed = microbench_cycles() - start;
+    total += elapsed;
+    best = (elapsed < best) ? elapsed : best;
+  }
+
+  microbench_report("palvideo_set_pixel", "-",
+    (uint64_t)pixels * MICROBENCH_ROUNDS, total, best / pixels);
+}
+
+
+
+void microbench_palvideo(void)
+{
+  palvideo_frame_prime();
+
+  for (int i = 0; i < MICROBENCH_MIX_MAX; i++) {
+    microbench_palvideo_char(&microbench_mix[i]);
+  }
+  microbench_palvideo_set_pixel();
+}
+
+
+
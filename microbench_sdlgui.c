@@ -0,0 +1,56 @@
+#include "sdlgui.c"
+#include "microbench.h"
+
+/* Included directly to reach the static functions in the SDL backend. */
+
+#define MICROBENCH_ROUNDS 64
+
+
+
+void microbench_sdlgui(void)
+{
+  terminal_char_t c;
+  uint64_t start, elapsed, total, best;
+  int rows = SDLGUI_HEIGHT / CHAR_HEIGHT;
+  int cols = SDLGUI_WIDTH / CHAR_WIDTH;
+
+  /* Render into a plain buffer, no window or renderer is needed. */
+  sdlgui_pixel_format = SDL_AllocFormat(SDL_PIXELFORMAT_ARGB8888);
+  sdlgui_pixels = calloc(SDLGUI_WIDTH * SDLGUI_HEIGHT, sizeof(Uint32));
+  if (sdlgui_pixel_format == NULL || sdlgui_pixels == NULL) {
+    fprintf(stderr, "Unable to set up SDL pixel buffer\n");
+    return;
+  }
+  sdlgui_palette_init();
+
+  for (int i = 0; i < MICROBENCH_MIX_MAX; i++) {
+    total = 0;
+    best = UINT64_MAX;
+    c.attribute = microbench_mix[i].attribute;
+
+    for (int round = 0; round < MICROBENCH_ROUNDS; round++) {
+      sdlgui_ticks = round * 250; /* Cover both blink phases. */
+      start = microbench_cycles();
+      for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < cols; col++) {
+          c.byte = 0x21 + (((row * 7) + col + round) % 94);
+          sdlgui_char(row, col, c);
+        }
+      }
+      elapsed = microbench_cycles() - start;
+      total += elapsed;
+      best = (elapsed < best) ? elapsed : best;
+    }
+
+    microbench_report("sdlgui_char", microbench_mix[i].name,
+      rows * cols * MICROBENCH_ROUNDS, total, best / (rows * cols));
+  }
+
+  free(sdlgui_pixels);
+  sdlgui_pixels = NULL;
+  SDL_FreeFormat(sdlgui_pixel_format);
+  sdlgui_pixel_format = NULL;
+}
+
+
+
@@ -0,0 +1,102 @@
+#include "terminal.c"
+#include "microbench.h"
+
+/* Included directly to reach the static functions in the terminal core. */
+
+#define MICROBENCH_BATCH  4096
+#define MICROBENCH_ROUNDS 64
+
+
+
+static void microbench_fill(uint8_t attribute)
+{
+  terminal_char_t c;
+
+  for (int row = 0; row <= row_max(); row++) {
+    for (int col = 0; col <= col_max(); col++) {
+      c.byte = 0x21 + (((row * 7) + col) % 94);
+      c.attribute = attribute;
+      screen_set(row, col, c);
+    }
+  }
+}
+
+
+
+static void microbench_print_char(const microbench_mix_t *mix)
+{
+  uint64_t start, elapsed, total = 0, best = UINT64_MAX;
+
+  terminal_init();
+  mode_wraparound = true;
+  cursor_print_attribute = mix->attribute;
+
+  for (int round = 0; round < MICROBENCH_ROUNDS; round++) {
+    start = microbench_cycles();
+    for (int i = 0; i < MICROBENCH_BATCH; i++) {
+      print_char(0x21 + ((i + round) % 94));
+      if (cursor_row == row_max() && cursor_col > col_max()) {
+        cursor_row = 0;
+      }
+    }
+    elapsed = microbench_cycles() - start;
+    total += elapsed;
+    best = (elapsed < best) ? elapsed : best;
+  }
+
+  microbench_report("print_char", mix->name,
+    MICROBENCH_BATCH * MICROBENCH_ROUNDS, total, best / MICROBENCH_BATCH);
+}
+
+
+
+static void microbench_single(const char *function, void (*call)(void),
+  const microbench_mix_t *mix)
+{
+  uint64_t start, elapsed, total = 0, best = UINT64_MAX;
+
+  terminal_init();
+
+  for (int round = 0; round < MICROBENCH_ROUNDS; round++) {
+    microbench_fill(mix->attribute);
+    cursor_row = row_max() / 2;
+    cursor_col = col_max() / 2;
+
+    start = microbench_cycles();
+    call();
+    elapsed = microbench_cycles() - start;
+    total += elapsed;
+    best = (elapsed < best) ? elapsed : best;
+  }
+
+  microbench_report(function, mix->name, MICROBENCH_ROUNDS, total, best);
+}
+
+
+
+static void microbench_erase_in_display(void)
+{
+  erase_in_display(2);
+}
+
+
+
+void microbench_terminal(void)
+{
+  for (int i = 0; i < MICROBENCH_MIX_MAX; i++) {
+    microbench_print_char(&microbench_mix[i]);
+  }
+  for (int i = 0; i < MICROBENCH_MIX_MAX; i++) {
+    microbench_single("scroll_up", scroll_up, &microbench_mix[i]);
+  }
+  for (int i = 0; i < MICROBENCH_MIX_MAX; i++) {
+    microbench_single("scroll_down", scroll_down, &microbench_mix[i]);
+  }
+  for (int i = 0; i < MICROBENCH_MIX_MAX; i++) {
+    microbench_single("erase_in_display", microbench_erase_in_display,
+      &microbench_mix[i]);
+  }
+}
+
+
+
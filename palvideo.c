@@ -6,6 +6,12 @@
 #include "hardware/dma.h"
 #include "palvideo.pio.h"
 #include "terminal.h"
+#include "stats.h"
+#include "trace.h"
+#include "profile.h"
+#include "latency.h"
+#include "status.h"
+#include "sram.h"
 
 #define ROW_MAX 24
 #define COL_MAX 80
@@ -13,6 +19,8 @@
 #define CHAR_HEIGHT 10
 #define FRAME_SCANLINES 625
 #define FRAME_SECTIONS 80
+#define STATUS_ROW ROW_MAX /* Drawn in the bottom border. */
+#define FIELD_US 20000 /* One PAL field. */
 
 extern uint8_t _binary_char_rom_start[];
 
@@ -22,6 +30,7 @@ static PIO palvideo_pio;
 static uint palvideo_sm;
 static uint32_t palvideo_frame[FRAME_SCANLINES][FRAME_SECTIONS];
 static uint32_t *palvideo_ap = &palvideo_frame[0][0];
+static bool palvideo_status_shown = false;
 
 
 
@@ -304,17 +313,74 @@ static inline void palvideo_char(uint8_t row, uint8_t col, terminal_char_t c)
 
 
 
-void palvideo_update(void)
+static void palvideo_status_clear(void)
+{
+  int y, section;
+
+  /* Restore the border, both interlaces as in palvideo_set_pixel(). */
+  for (y = 0; y < CHAR_HEIGHT; y++) {
+    for (section = 18; section < (18 + 55); section++) {
+      palvideo_frame[(STATUS_ROW * 10) + y + 5 + 42][section] = 0xAAAAAAAA;
+      palvideo_frame[(STATUS_ROW * 10) + y + 317 + 42][section] = 0xAAAAAAAA;
+    }
+  }
+}
+
+
+
+static void palvideo_status(void)
+{
+  char text[STATUS_COLS + 1];
+  terminal_char_t c;
+
+  if (status_visible != palvideo_status_shown) {
+    palvideo_status_shown = status_visible;
+    if (! palvideo_status_shown) {
+      palvideo_status_clear();
+    }
+  }
+
+  if (! palvideo_status_shown) {
+    return;
+  }
+
+  if (status_refresh(text)) {
+    c.attribute = (0x1 << TERMINAL_ATTRIBUTE_REVERSE);
+    for (int col = 0; col < COL_MAX; col++) {
+      c.byte = text[col];
+      palvideo_char(STATUS_ROW, col, c);
+    }
+  }
+}
+
+
+
+void SRAM_FUNC(palvideo_update)(void)
 {
   int row, col;
+  int cells = 0;
+  uint32_t start;
 
+  start = profile_pass_start();
+  latency_pass_start();
+  trace(TRACE_RENDER_START, 0, 0);
   for (row = 0; row < ROW_MAX; row++) {
     for (col = 0; col < COL_MAX; col++) {
       if (terminal_char_changed(row, col)) {
         palvideo_char(row, col, terminal_char_get(row, col));
+        cells++;
       }
     }
   }
+
+  stats_count(STATS_RENDER_PASSES);
+  stats_count_add(STATS_CELLS_RENDERED, cells);
+  stats_peak_update(STATS_PEAK_CELLS_PER_PASS, cells);
+  trace(TRACE_RENDER_END, 0, cells);
+
+  palvideo_status();
+  profile_pass_end(start, cells, FIELD_US);
+  latency_pass_end();
 }
 
 
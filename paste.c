@@ -0,0 +1,192 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "paste.h"
+#include "terminal.h"
+#include "eia.h"
+#include "timer.h"
+
+/* Sends pasted text from its own thread, no faster than the line can carry
+   it, so neither the remote side nor the GUI thread is overrun. */
+
+#define PASTE_SIZE_MAX (1024 * 1024)
+#define PASTE_TICK_US 1000
+#define PASTE_BITS_PER_BYTE 10 /* Start, eight data and stop bit. */
+
+static pthread_mutex_t paste_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t paste_cond = PTHREAD_COND_INITIALIZER;
+static uint8_t *paste_data = NULL;
+static size_t paste_len = 0;
+static bool paste_bracketed = false;
+static volatile bool paste_busy = false;
+static long paste_rate = 0; /* Bytes per second. */
+
+
+
+size_t paste_utf8_decode(const char *text, uint8_t *out, size_t size)
+{
+  const uint8_t *in = (const uint8_t *)text;
+  uint32_t code;
+  int follow;
+  size_t len = 0;
+
+  /* Latin-1 is what the terminal sends, anything above is a '?'. */
+  while (*in != '\0' && len < size) {
+    if (*in < 0x80) {
+      code = *in++;
+      follow = 0;
+    } else if ((*in & 0xE0) == 0xC0) {
+      code = *in++ & 0x1F;
+      follow = 1;
+    } else if ((*in & 0xF0) == 0xE0) {
+      code = *in++ & 0x0F;
+      follow = 2;
+    } else if ((*in & 0xF8) == 0xF0) {
+      code = *in++ & 0x07;
+      follow = 3;
+    } else {
+      in++; /* Stray continuation byte. */
+      continue;
+    }
+    for (; follow > 0 && (*in & 0xC0) == 0x80; follow--) {
+      code = (code << 6) | (*in++ & 0x3F);
+    }
+    out[len++] = (follow == 0 && code <= 0xFF) ? code : '?';
+  }
+  return len;
+}
+
+
+
+static void paste_paced(const uint8_t *data, size_t len)
+{
+  uint32_t start = timer_us();
+  uint64_t due;
+  size_t sent = 0;
+
+  while (sent < len) {
+    /* Everything due by now is sent, then the rest of the tick is slept. */
+    due = ((uint64_t)(timer_us() - start) * paste_rate) / 1000000 + 1;
+    for (; sent < len && sent < due; sent++) {
+      eia_send(data[sent]);
+    }
+    if (sent < len) {
+      usleep(PASTE_TICK_US);
+    }
+  }
+}
+
+
+
+static void *paste_thread(void *argp)
+{
+  static const uint8_t begin[] = "\x1b[200~";
+  static const uint8_t end[] = "\x1b[201~";
+
+  (void)argp;
+
+  while (1) {
+    pthread_mutex_lock(&paste_mutex);
+    while (paste_data == NULL) {
+      pthread_cond_wait(&paste_cond, &paste_mutex);
+    }
+    pthread_mutex_unlock(&paste_mutex);
+
+    if (paste_bracketed) {
+      paste_paced(begin, sizeof(begin) - 1);
+    }
+    paste_paced(paste_data, paste_len);
+    if (paste_bracketed) {
+      paste_paced(end, sizeof(end) - 1);
+    }
+
+    pthread_mutex_lock(&paste_mutex);
+    free(paste_data);
+    paste_data = NULL;
+    paste_busy = false;
+    pthread_mutex_unlock(&paste_mutex);
+  }
+
+  return NULL;
+}
+
+
+
+int paste_init(long baud)
+{
+  pthread_t tid;
+
+  paste_rate = baud / PASTE_BITS_PER_BYTE;
+  if (paste_rate < 1) {
+    paste_rate = 1;
+  }
+  if (pthread_create(&tid, NULL, paste_thread, NULL) != 0) {
+    fprintf(stderr, "pthread_create() failed with errno: %d\n", errno);
+    return -1;
+  }
+  pthread_detach(tid);
+  return 0;
+}
+
+
+
+bool paste_start(const char *text)
+{
+  uint8_t *data;
+  size_t len, out;
+
+  if (paste_busy) {
+    return false; /* One at a time, the rest would only be queued. */
+  }
+
+  len = strlen(text);
+  if (len > PASTE_SIZE_MAX) {
+    len = PASTE_SIZE_MAX;
+  }
+  data = malloc(len + 1);
+  if (data == NULL) {
+    return false;
+  }
+  len = paste_utf8_decode(text, data, len);
+
+  /* Lines end in what the Return key sends. In a bracketed paste the end
+     marker must not be forged by the text, so ESC is left out. */
+  out = 0;
+  for (size_t i = 0; i < len; i++) {
+    if (data[i] == '\r' && (i + 1) < len && data[i + 1] == '\n') {
+      continue;
+    }
+    if (data[i] == 0x1B && terminal_bracketed_paste()) {
+      continue;
+    }
+    data[out++] = data[i];
+  }
+  if (out == 0) {
+    free(data);
+    return false;
+  }
+
+  pthread_mutex_lock(&paste_mutex);
+  paste_data = data;
+  paste_len = out;
+  paste_bracketed = terminal_bracketed_paste();
+  paste_busy = true;
+  pthread_cond_signal(&paste_cond);
+  pthread_mutex_unlock(&paste_mutex);
+  return true;
+}
+
+
+
+bool paste_active(void)
+{
+  return paste_busy;
+}
+
+
+
@@ -0,0 +1,13 @@
+#ifndef _PASTE_H
+#define _PASTE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+int paste_init(long baud);
+bool paste_start(const char *text);
+bool paste_active(void);
+size_t paste_utf8_decode(const char *text, uint8_t *out, size_t size);
+
+#endif /* _PASTE_H */
@@ -0,0 +1,74 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "profile.h"
+#include "terminal.h"
+#include "timer.h"
+#include "diag.h"
+
+uint32_t profile_histogram[PROFILE_HISTOGRAM_MAX][PROFILE_BUCKETS];
+uint32_t profile_max[PROFILE_HISTOGRAM_MAX];
+uint32_t profile_overruns = 0;
+
+static bool profile_damaged = false;
+static uint32_t profile_damage_us;
+
+static const char *profile_histogram_name[PROFILE_HISTOGRAM_MAX] = {
+  "pass_us",
+  "cells",
+  "lag_us",
+  "key_echo_us",
+  "key_apply_us",
+  "key_present_us",
+};
+
+
+
+uint32_t profile_pass_start(void)
+{
+  /* Changes made after this point are left for the next pass. */
+  profile_damaged = terminal_damage_take(&profile_damage_us);
+  return timer_us();
+}
+
+
+
+void profile_pass_end(uint32_t start_us, uint32_t cells, uint32_t budget_us)
+{
+  uint32_t now = timer_us();
+
+  profile_record(PROFILE_PASS_US, now - start_us);
+  profile_record(PROFILE_CELLS, cells);
+  if ((now - start_us) > budget_us) {
+    profile_overruns++;
+  }
+
+  /* Lag is from the oldest change picked up by this pass until now. */
+  if (profile_damaged) {
+    profile_record(PROFILE_LAG_US, now - profile_damage_us);
+  }
+}
+
+
+
+void profile_report(diag_put_t put)
+{
+  /* CSV, so a dump can be pasted straight into a spreadsheet or script. */
+  diag_printf(put, "histogram,from,to,count\n");
+  for (int i = 0; i < PROFILE_HISTOGRAM_MAX; i++) {
+    for (int bucket = 0; bucket < PROFILE_BUCKETS; bucket++) {
+      if (profile_histogram[i][bucket] == 0) {
+        continue;
+      }
+      diag_printf(put, "%s,%lu,%lu,%lu\n", profile_histogram_name[i],
+        (bucket == 0) ? 0UL : (1UL << (bucket - 1)),
+        (1UL << bucket) - 1,
+        (unsigned long)profile_histogram[i][bucket]);
+    }
+    diag_printf(put, "%s,max,,%lu\n", profile_histogram_name[i],
+      (unsigned long)profile_max[i]);
+  }
+  diag_printf(put, "overruns,,,%lu\n", (unsigned long)profile_overruns);
+}
+
+
+
@@ -0,0 +1,43 @@
+#ifndef _PROFILE_H
+#define _PROFILE_H
+
+#include <stdint.h>
+#include "diag.h"
+
+#define DIAG_PROFILE 902
+
+#define PROFILE_BUCKETS 24 /* Log2, bucket n holds values below 2^n. */
+
+typedef enum {
+  PROFILE_PASS_US,
+  PROFILE_CELLS,
+  PROFILE_LAG_US,
+  PROFILE_KEY_ECHO_US,
+  PROFILE_KEY_APPLY_US,
+  PROFILE_KEY_PRESENT_US,
+  PROFILE_HISTOGRAM_MAX,
+} profile_histogram_t;
+
+extern uint32_t profile_histogram[PROFILE_HISTOGRAM_MAX][PROFILE_BUCKETS];
+extern uint32_t profile_max[PROFILE_HISTOGRAM_MAX];
+extern uint32_t profile_overruns;
+
+static inline void profile_record(profile_histogram_t histogram,
+  uint32_t value)
+{
+  int bucket = (value == 0) ? 0 : (32 - __builtin_clz(value));
+
+  if (bucket >= PROFILE_BUCKETS) {
+    bucket = PROFILE_BUCKETS - 1;
+  }
+  profile_histogram[histogram][bucket]++;
+  if (value > profile_max[histogram]) {
+    profile_max[histogram] = value;
+  }
+}
+
+uint32_t profile_pass_start(void);
+void profile_pass_end(uint32_t start_us, uint32_t cells, uint32_t budget_us);
+void profile_report(diag_put_t put);
+
+#endif /* _PROFILE_H */
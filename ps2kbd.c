@@ -6,7 +6,11 @@
 #include "ps2kbd.pio.h"
 #include "eia.h"
 #include "terminal.h"
-#include "error.h"
+#include "stats.h"
+#include "status.h"
+#include "trace.h"
+#include "latency.h"
+#include "sram.h"
 
 
 
@@ -141,7 +145,7 @@ static inline int ps2kbd_parity(uint32_t data)
 
 
 
-static void ps2kbd_handle_scancode(uint8_t scancode)
+static void SRAM_FUNC(ps2kbd_handle_scancode)(uint8_t scancode)
 {
   switch (ps2kbd_state) {
   case PS2KBD_STATE_IDLE:
@@ -255,6 +259,10 @@ static void ps2kbd_handle_scancode(uint8_t scancode)
           eia_send('~');
           break;
 
+        case 0x7E: /* Scroll Lock */
+          status_toggle();
+          break;
+
 #ifdef NUMLOCK_OFF
         case 0x71: /* KP Delete */
           eia_send(0x1B);
@@ -327,6 +335,7 @@ static void ps2kbd_handle_scancode(uint8_t scancode)
           if (scancode < 128) {
             if (key_pressed[0x12] || key_pressed[0x59]) { /* Shift */
               if (shift_key_to_byte[scancode] >= 0) {
+                terminal_predict(shift_key_to_byte[scancode]);
                 eia_send(shift_key_to_byte[scancode]);
                 if (shift_key_to_byte[scancode] == '\r' &&
                   terminal_send_crlf()) {
@@ -339,10 +348,12 @@ static void ps2kbd_handle_scancode(uint8_t scancode)
               }
             } else if (key_ext_pressed[0x11]) { /* Alt Gr */
               if (altgr_key_to_byte[scancode] >= 0) {
+                terminal_predict(altgr_key_to_byte[scancode]);
                 eia_send(altgr_key_to_byte[scancode]);
               }
             } else {
               if (key_to_byte[scancode] >= 0) {
+                terminal_predict(key_to_byte[scancode]);
                 eia_send(key_to_byte[scancode]);
                 if (key_to_byte[scancode] == '\r' &&
                   terminal_send_crlf()) {
@@ -518,8 +529,8 @@ static void ps2kbd_handle_scancode(uint8_t scancode)
     break;
 
   case PS2KBD_STATE_PAUSE_7:
-    if (scancode == 0x77) {
-      /* 'Pause' press not implemented. */
+    if (scancode == 0x77) { /* Pause */
+      terminal_predict_toggle();
     }
     ps2kbd_state = PS2KBD_STATE_IDLE;
     break;
@@ -533,8 +544,8 @@ static void ps2kbd_handle_scancode(uint8_t scancode)
     break;
 
   case PS2KBD_STATE_PRINT_SCREEN_2:
-    if (scancode == 0x7C) {
-      /* 'Print Screen' press not implemented. */
+    if (scancode == 0x7C) { /* Print Screen */
+      trace_request();
     }
     ps2kbd_state = PS2KBD_STATE_IDLE;
     break;
@@ -567,13 +578,18 @@ static void ps2kbd_handle_scancode(uint8_t scancode)
 
 
 
-static void ps2kbd_isr(void)
+static void SRAM_FUNC(ps2kbd_isr)(void)
 {
   uint32_t data;
+  uint32_t start, tx_bytes;
 
+  start = timer_us();
+  tx_bytes = stats_counter[STATS_TX_BYTES];
   data = pio_sm_get(ps2kbd_pio, ps2kbd_sm);
+  trace(TRACE_PS2_ISR, 0, data >> 23 & 0xFF);
   if (ps2kbd_parity(data) == 0) {
-    error_ps2_parity++;
+    stats_count(STATS_PS2_PARITY);
+    trace(TRACE_PS2_PARITY, 0, data >> 23 & 0xFF);
     ps2kbd_reset_pressed();
 
     /* Reset PIO in case bits have shifted. */
@@ -585,6 +601,10 @@ static void ps2kbd_isr(void)
     ps2kbd_handle_scancode(data >> 23 & 0xFF);
   }
 
+  if (stats_counter[STATS_TX_BYTES] != tx_bytes) {
+    latency_key(start); /* The key produced output to the host. */
+  }
+
   pio_interrupt_clear(ps2kbd_pio, 0);
 }
 
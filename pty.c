@@ -0,0 +1,48 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pty.h>
+#include <sys/ioctl.h>
+#include "pty.h"
+
+#define PTY_ROWS 24
+#define PTY_COLS 80
+#define PTY_TERM "vt100"
+
+
+
+int pty_open(const char *command)
+{
+  int fd;
+  pid_t pid;
+  struct winsize ws = { PTY_ROWS, PTY_COLS, 0, 0 };
+  const char *shell;
+
+  pid = forkpty(&fd, NULL, NULL, &ws);
+  if (pid == -1) {
+    fprintf(stderr, "forkpty() failed with errno: %d\n", errno);
+    return -1;
+  }
+
+  if (pid == 0) {
+    /* The child is the host, on a cooked tty like a serial login. */
+    setenv("TERM", PTY_TERM, 1);
+    if (command != NULL) {
+      execl("/bin/sh", "sh", "-c", command, (char *)NULL);
+    } else {
+      shell = getenv("SHELL");
+      if (shell == NULL) {
+        shell = "/bin/sh";
+      }
+      execl(shell, shell, (char *)NULL);
+    }
+    fprintf(stderr, "exec() failed with errno: %d\n", errno);
+    _exit(127);
+  }
+
+  return fd;
+}
+
+
+
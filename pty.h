@@ -0,0 +1,6 @@
+#ifndef _PTY_H
+#define _PTY_H
+
+int pty_open(const char *command);
+
+#endif /* _PTY_H */
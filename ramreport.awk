@@ -0,0 +1,76 @@
+# Static RAM used per module, from the linker map of the Pico build:
+#   awk -f ramreport.awk terminominal.elf.map
+
+BEGIN {
+  sram_start = 536870912 # 0x20000000
+  sram_end = sram_start + (264 * 1024)
+}
+
+function hex(s,    n, i, c) {
+  n = 0
+  s = tolower(substr(s, 3))
+  for (i = 1; i <= length(s); i++) {
+    c = index("0123456789abcdef", substr(s, i, 1)) - 1
+    n = (n * 16) + c
+  }
+  return n
+}
+
+function module(path) {
+  # Objects are named after their source, archive members after the archive.
+  sub(/\.(c|S)\.obj$/, "", path)
+  sub(/\.o\)$/, ")", path)
+  sub(/\.o$/, "", path)
+  sub(/^.*\//, "", path)
+  return path
+}
+
+function account(name, addr, size, path,    a) {
+  if (name !~ /^(\.data|\.bss|\.stack|\.heap|\.scratch|\.uninitialized|\.time_critical|COMMON)/) {
+    return
+  }
+  a = hex(addr)
+  if (a < sram_start || a >= sram_end) {
+    return
+  }
+  used[module(path)] += hex(size)
+  total += hex(size)
+}
+
+/^Linker script and memory map/ {
+  mapping = 1
+  next
+}
+
+! mapping {
+  next
+}
+
+# Input sections are indented, long names wrap onto the next line.
+/^ [^ ]+$/ {
+  pending = $1
+  next
+}
+
+/^ +0x[0-9a-f]+ +0x[0-9a-f]+ +[^ ]/ && pending != "" {
+  account(pending, $1, $2, $3)
+  pending = ""
+  next
+}
+
+/^ [^ *]+ +0x[0-9a-f]+ +0x[0-9a-f]+ +[^ ]/ {
+  account($1, $2, $3, $4)
+}
+
+{
+  pending = ""
+}
+
+END {
+  for (m in used) {
+    printf("%8d  %s\n", used[m], m) | "sort -rn"
+  }
+  close("sort -rn")
+  printf("%8d  total of %d bytes SRAM, %d free\n",
+    total, sram_end - sram_start, (sram_end - sram_start) - total)
+}
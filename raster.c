@@ -0,0 +1,129 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "raster.h"
+#include "terminal.h"
+
+extern uint8_t _binary_char_rom_start[];
+
+
+
+static inline raster_shade_t raster_shade(bool blink_off, bool on,
+  terminal_char_t c)
+{
+  if (on ^ ((c.attribute >> TERMINAL_ATTRIBUTE_REVERSE) & 0x1)) {
+    if (((c.attribute >> TERMINAL_ATTRIBUTE_BLINK) & 0x1) && blink_off) {
+      return RASTER_SHADE_OFF;
+    } else {
+      if ((c.attribute >> TERMINAL_ATTRIBUTE_BOLD) & 0x1) {
+        return RASTER_SHADE_BOLD;
+      } else {
+        return RASTER_SHADE_ON;
+      }
+    }
+  } else {
+    if (((c.attribute >> TERMINAL_ATTRIBUTE_REVERSE) & 0x1) &&
+      (((c.attribute >> TERMINAL_ATTRIBUTE_BLINK) & 0x1) && blink_off)) {
+      if ((c.attribute >> TERMINAL_ATTRIBUTE_BOLD) & 0x1) {
+        return RASTER_SHADE_BOLD;
+      } else {
+        return RASTER_SHADE_ON;
+      }
+    } else {
+      return RASTER_SHADE_OFF;
+    }
+  }
+}
+
+
+
+static void raster_tile_render(const raster_t *raster, uint32_t *tile,
+  terminal_char_t c, bool blink_off)
+{
+  int y, x;
+  uint8_t char_data;
+  int offset;
+  bool on;
+  uint32_t *line;
+
+  for (y = 0; y < RASTER_CHAR_HEIGHT; y++) {
+    offset = (c.byte * RASTER_CHAR_HEIGHT * 2) + (y * 2);
+    line = &tile[y * RASTER_CHAR_WIDTH];
+
+    char_data = _binary_char_rom_start[offset];
+    for (x = 0; x < 8; x++) {
+      if (((c.attribute >> TERMINAL_ATTRIBUTE_UNDERLINE) & 0x1)
+        && y == (RASTER_CHAR_HEIGHT - 1)) {
+        on = true;
+      } else {
+        on = (char_data >> x) & 0x1;
+      }
+      line[7 - x] = raster->palette[raster_shade(blink_off, on, c)];
+    }
+
+    char_data = _binary_char_rom_start[offset + 1];
+    for (x = 0; x < 3; x++) {
+      if (((c.attribute >> TERMINAL_ATTRIBUTE_UNDERLINE) & 0x1)
+        && y == (RASTER_CHAR_HEIGHT - 1)) {
+        on = true;
+      } else {
+        on = (char_data >> x) & 0x1;
+      }
+      line[(2 - x) + 8] = raster->palette[raster_shade(blink_off, on, c)];
+    }
+  }
+}
+
+
+
+void raster_char(raster_t *raster, uint8_t row, uint8_t col,
+  terminal_char_t c)
+{
+  uint32_t scratch[RASTER_TILE_PIXELS];
+  uint32_t *tile, *line;
+  bool blink_off;
+  int index;
+
+  /* Only the attribute bits that change the pixels, and the blink phase
+     only for blinking cells. */
+  c.attribute &= ((RASTER_TILE_ATTRIBUTES - 1) << TERMINAL_ATTRIBUTE_BOLD);
+  blink_off = ((c.attribute >> TERMINAL_ATTRIBUTE_BLINK) & 0x1) &&
+    raster->blink_off;
+  index = (((c.byte * RASTER_TILE_ATTRIBUTES) +
+    (c.attribute >> TERMINAL_ATTRIBUTE_BOLD)) * 2) + blink_off;
+
+  if (raster->tiles == NULL) {
+    raster->tiles = malloc(RASTER_TILE_COUNT * RASTER_TILE_PIXELS *
+      sizeof(uint32_t));
+    raster->tile_valid = calloc(RASTER_TILE_COUNT, sizeof(bool));
+    if (raster->tiles == NULL || raster->tile_valid == NULL) {
+      free(raster->tiles);
+      free(raster->tile_valid);
+      raster->tiles = NULL;
+      raster->tile_valid = NULL;
+    }
+  }
+
+  if (raster->tiles != NULL) {
+    tile = &raster->tiles[index * RASTER_TILE_PIXELS];
+    if (! raster->tile_valid[index]) {
+      raster_tile_render(raster, tile, c, blink_off);
+      raster->tile_valid[index] = true;
+    }
+  } else {
+    tile = scratch; /* Out of memory, rendered every time. */
+    raster_tile_render(raster, tile, c, blink_off);
+  }
+
+  line = &raster->pixels[(row * RASTER_CHAR_HEIGHT * raster->pitch) +
+    (col * RASTER_CHAR_WIDTH)];
+  for (int y = 0; y < RASTER_CHAR_HEIGHT; y++) {
+    memcpy(line, &tile[y * RASTER_CHAR_WIDTH],
+      RASTER_CHAR_WIDTH * sizeof(uint32_t));
+    line += raster->pitch;
+  }
+}
+
+
+
@@ -0,0 +1,42 @@
+#ifndef _RASTER_H
+#define _RASTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "terminal.h"
+
+#define RASTER_CHAR_WIDTH  11
+#define RASTER_CHAR_HEIGHT 10
+
+typedef enum {
+  RASTER_SHADE_OFF,
+  RASTER_SHADE_BOLD,
+  RASTER_SHADE_ON,
+  RASTER_SHADE_MAX,
+} raster_shade_t;
+
+/* Gray levels of the shades, mapped to pixel values through the palette. */
+#define RASTER_LEVEL_OFF  0x00
+#define RASTER_LEVEL_BOLD 0x7F
+#define RASTER_LEVEL_ON   0xFF
+
+/* Each cell is copied from a tile, rendered once for every combination
+   of glyph, attribute and blink phase that is drawn. The palette must be
+   set before the first character. */
+#define RASTER_TILE_PIXELS (RASTER_CHAR_WIDTH * RASTER_CHAR_HEIGHT)
+#define RASTER_TILE_ATTRIBUTES 16 /* Bold, underline, blink and reverse. */
+#define RASTER_TILE_COUNT (256 * RASTER_TILE_ATTRIBUTES * 2)
+
+typedef struct raster_s {
+  uint32_t *pixels;
+  int pitch; /* In pixels. */
+  uint32_t palette[RASTER_SHADE_MAX];
+  bool blink_off; /* Second half of the blink period. */
+  uint32_t *tiles; /* Allocated on first use. */
+  bool *tile_valid;
+} raster_t;
+
+void raster_char(raster_t *raster, uint8_t row, uint8_t col,
+  terminal_char_t c);
+
+#endif /* _RASTER_H */
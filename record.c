@@ -0,0 +1,365 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "record.h"
+#include "terminal.h"
+
+#define RECORD_BUFFER_SIZE (256 * 1024)
+#define RECORD_FLUSH_US 100000
+#define RECORD_COALESCE_US 1000
+#define RECORD_LEN_MAX 0xFFFF
+#define RECORD_DELTA_MAX 0xFFFFFFFF
+#define REPLAY_SLEEP_MAX_US 1000
+
+
+
+static FILE *record_fh = NULL;
+static pthread_t record_thread;
+static pthread_mutex_t record_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t record_cond = PTHREAD_COND_INITIALIZER;
+static volatile bool record_stop = false;
+static bool record_woken = false;
+
+/* Double buffered, the writer thread swaps and writes the full one. */
+static uint8_t record_buffer[2][RECORD_BUFFER_SIZE];
+static uint8_t *record_fill_buffer = record_buffer[0];
+static size_t record_fill = 0;
+static long record_last_header = -1;
+static record_direction_t record_last_direction;
+static uint64_t record_last_us = 0;
+static uint64_t record_last_start_us = 0;
+static unsigned long record_dropped = 0;
+
+static uint8_t *replay_data = NULL;
+static size_t replay_size = 0;
+static size_t replay_pos = 0;
+static double replay_speed = 1.0;
+static uint64_t replay_start_us;
+static uint64_t replay_time_us; /* Recorded time of the next record. */
+static unsigned long replay_bytes = 0;
+
+
+
+static uint64_t record_now_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+
+
+static inline uint32_t record_get32(const uint8_t *p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint16_t record_get16(const uint8_t *p)
+{
+  return p[0] | (p[1] << 8);
+}
+
+
+
+static inline void record_wake(void)
+{
+  /* Early flush once half full, signalled only on the crossing. */
+  if (record_fill >= (RECORD_BUFFER_SIZE / 2) && ! record_woken) {
+    record_woken = true;
+    pthread_cond_signal(&record_cond);
+  }
+}
+
+
+
+static void *record_writer(void *argp)
+{
+  uint8_t *full;
+  size_t len;
+  bool stop;
+  struct timespec ts;
+
+  (void)argp;
+  do {
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += RECORD_FLUSH_US * 1000;
+    if (ts.tv_nsec >= 1000000000) {
+      ts.tv_sec++;
+      ts.tv_nsec -= 1000000000;
+    }
+
+    /* Only the swap is done under the lock, never the write. */
+    pthread_mutex_lock(&record_mutex);
+    if (! record_stop && record_fill < (RECORD_BUFFER_SIZE / 2)) {
+      pthread_cond_timedwait(&record_cond, &record_mutex, &ts);
+    }
+    stop = record_stop;
+    full = record_fill_buffer;
+    len = record_fill;
+    record_fill_buffer = (full == record_buffer[0]) ?
+      record_buffer[1] : record_buffer[0];
+    record_fill = 0;
+    record_woken = false;
+    record_last_header = -1;
+    pthread_mutex_unlock(&record_mutex);
+
+    if (len > 0) {
+      fwrite(full, 1, len, record_fh);
+      fflush(record_fh);
+    }
+  } while (! stop);
+
+  return NULL;
+}
+
+
+
+int record_open(const char *path)
+{
+  record_fh = fopen(path, "wb");
+  if (record_fh == NULL) {
+    fprintf(stderr, "Unable to open for writing: %s\n", path);
+    return -1;
+  }
+  fwrite(RECORD_MAGIC, 1, RECORD_MAGIC_LEN, record_fh);
+
+  record_last_us = record_now_us();
+  if (pthread_create(&record_thread, NULL, record_writer, NULL) != 0) {
+    fprintf(stderr, "pthread_create() failed with errno: %d\n", errno);
+    fclose(record_fh);
+    record_fh = NULL;
+    return -1;
+  }
+
+  atexit(record_close);
+  return 0;
+}
+
+
+
+void record_close(void)
+{
+  if (record_fh == NULL) {
+    return;
+  }
+
+  pthread_mutex_lock(&record_mutex);
+  record_stop = true;
+  pthread_cond_signal(&record_cond);
+  pthread_mutex_unlock(&record_mutex);
+  pthread_join(record_thread, NULL);
+  fclose(record_fh);
+  record_fh = NULL;
+
+  if (record_dropped > 0) {
+    fprintf(stderr, "Recorder dropped %lu bytes\n", record_dropped);
+  }
+}
+
+
+
+void record_data(record_direction_t direction, const uint8_t *data,
+  size_t len)
+{
+  uint64_t now, delta;
+  uint8_t *header;
+  size_t record_len;
+
+  if (record_fh == NULL || len == 0) {
+    return;
+  }
+
+  now = record_now_us();
+  pthread_mutex_lock(&record_mutex);
+
+  /* Bytes arriving close together extend the previous record. */
+  if (record_last_header >= 0 && direction == record_last_direction &&
+      (now - record_last_start_us) < RECORD_COALESCE_US) {
+    header = &record_fill_buffer[record_last_header];
+    record_len = record_get16(&header[5]);
+    if ((record_len + len) <= RECORD_LEN_MAX &&
+        (record_fill + len) <= RECORD_BUFFER_SIZE) {
+      memcpy(&record_fill_buffer[record_fill], data, len);
+      record_fill += len;
+      record_len += len;
+      header[5] = record_len & 0xFF;
+      header[6] = record_len >> 8;
+      record_wake();
+      pthread_mutex_unlock(&record_mutex);
+      return;
+    }
+  }
+
+  if ((record_fill + RECORD_HEADER_LEN + len) > RECORD_BUFFER_SIZE ||
+      len > RECORD_LEN_MAX) {
+    record_dropped += len; /* Never stall the caller on a slow disk. */
+    pthread_mutex_unlock(&record_mutex);
+    return;
+  }
+
+  delta = now - record_last_us;
+  if (delta > RECORD_DELTA_MAX) {
+    delta = RECORD_DELTA_MAX;
+  }
+  header = &record_fill_buffer[record_fill];
+  header[0] = delta & 0xFF;
+  header[1] = (delta >> 8) & 0xFF;
+  header[2] = (delta >> 16) & 0xFF;
+  header[3] = (delta >> 24) & 0xFF;
+  header[4] = direction;
+  header[5] = len & 0xFF;
+  header[6] = len >> 8;
+  memcpy(&header[RECORD_HEADER_LEN], data, len);
+
+  record_last_header = record_fill;
+  record_last_direction = direction;
+  record_last_us = now;
+  record_last_start_us = now;
+  record_fill += RECORD_HEADER_LEN + len;
+  record_wake();
+
+  pthread_mutex_unlock(&record_mutex);
+}
+
+
+
+int replay_open(const char *path, double speed)
+{
+  FILE *fh;
+  long size;
+
+  fh = fopen(path, "rb");
+  if (fh == NULL) {
+    fprintf(stderr, "Unable to open recording: %s\n", path);
+    return -1;
+  }
+
+  /* Fails on a pipe, which would otherwise give a size of -1. */
+  if (fseek(fh, 0, SEEK_END) != 0 || (size = ftell(fh)) == -1 ||
+      fseek(fh, 0, SEEK_SET) != 0) {
+    fprintf(stderr, "Unable to size recording: %s\n", path);
+    fclose(fh);
+    return -1;
+  }
+
+  replay_data = malloc(size);
+  if (replay_data == NULL || fread(replay_data, 1, size, fh) != (size_t)size ||
+      size < RECORD_MAGIC_LEN ||
+      memcmp(replay_data, RECORD_MAGIC, RECORD_MAGIC_LEN) != 0) {
+    fprintf(stderr, "Not a recording: %s\n", path);
+    free(replay_data);
+    replay_data = NULL;
+    fclose(fh);
+    return -1;
+  }
+  fclose(fh);
+
+  replay_size = size;
+  replay_pos = RECORD_MAGIC_LEN;
+  replay_speed = speed;
+  replay_time_us = 0;
+  replay_bytes = 0;
+  replay_start_us = record_now_us();
+  return 0;
+}
+
+
+
+bool replay_update(void)
+{
+  uint64_t due, elapsed;
+  const uint8_t *header;
+  uint16_t len;
+
+  if (replay_data == NULL) {
+    return false;
+  }
+
+  if ((replay_pos + RECORD_HEADER_LEN) > replay_size) {
+    fprintf(stderr, "Replay of %lu bytes done in %.3f seconds\n",
+      replay_bytes, (double)(record_now_us() - replay_start_us) / 1000000.0);
+    free(replay_data);
+    replay_data = NULL;
+    return false;
+  }
+
+  header = &replay_data[replay_pos];
+  len = record_get16(&header[5]);
+  if ((replay_pos + RECORD_HEADER_LEN + len) > replay_size) {
+    replay_pos = replay_size; /* Truncated, the rest is dropped. */
+    return true;
+  }
+
+  /* A speed of zero plays as fast as possible. */
+  if (replay_speed > 0.0) {
+    due = (uint64_t)((replay_time_us + record_get32(header)) / replay_speed);
+    elapsed = record_now_us() - replay_start_us;
+    if (elapsed < due) {
+      usleep(((due - elapsed) < REPLAY_SLEEP_MAX_US) ?
+        (due - elapsed) : REPLAY_SLEEP_MAX_US);
+      return true;
+    }
+  }
+  replay_time_us += record_get32(header);
+
+  /* Only the host side is played back, replies are regenerated. */
+  if (header[4] == RECORD_IN) {
+    terminal_handle_buffer(&header[RECORD_HEADER_LEN], len);
+    replay_bytes += len;
+  }
+  replay_pos += RECORD_HEADER_LEN + len;
+  return true;
+}
+
+
+
+const uint8_t *record_next(const uint8_t *data, size_t size, size_t *pos,
+  uint32_t *delta_us, record_direction_t *direction, uint16_t *len)
+{
+  /* Start with *pos at zero, NULL is returned at the end. */
+  if (*pos < RECORD_MAGIC_LEN) {
+    *pos = RECORD_MAGIC_LEN;
+  }
+  if ((*pos + RECORD_HEADER_LEN) > size) {
+    return NULL;
+  }
+  *len = record_get16(&data[*pos + 5]);
+  if ((*pos + RECORD_HEADER_LEN + *len) > size) {
+    return NULL; /* Truncated. */
+  }
+  *delta_us = record_get32(&data[*pos]);
+  *direction = data[*pos + 4];
+  *pos += RECORD_HEADER_LEN + *len;
+  return &data[*pos - *len];
+}
+
+
+
+size_t record_extract(const uint8_t *data, size_t size, uint8_t *out)
+{
+  size_t pos = 0;
+  size_t out_len = 0;
+  const uint8_t *chunk;
+  uint32_t delta_us;
+  record_direction_t direction;
+  uint16_t len;
+
+  /* Host to terminal bytes only, for feeding the parser without pacing. */
+  while ((chunk = record_next(data, size, &pos, &delta_us, &direction,
+    &len)) != NULL) {
+    if (direction == RECORD_IN) {
+      memcpy(&out[out_len], chunk, len);
+      out_len += len;
+    }
+  }
+  return out_len;
+}
+
+
+
@@ -0,0 +1,31 @@
+#ifndef _RECORD_H
+#define _RECORD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* File: magic, then records of a 4 byte time delta in microseconds,
+   a direction byte and a 2 byte length, little endian, then the data. */
+#define RECORD_MAGIC "TMREC01\n"
+#define RECORD_MAGIC_LEN 8
+#define RECORD_HEADER_LEN 7
+
+typedef enum {
+  RECORD_IN  = 0,
+  RECORD_OUT = 1,
+} record_direction_t;
+
+int record_open(const char *path);
+void record_close(void);
+void record_data(record_direction_t direction, const uint8_t *data,
+  size_t len);
+
+int replay_open(const char *path, double speed);
+bool replay_update(void);
+
+const uint8_t *record_next(const uint8_t *data, size_t size, size_t *pos,
+  uint32_t *delta_us, record_direction_t *direction, uint16_t *len);
+size_t record_extract(const uint8_t *data, size_t size, uint8_t *out);
+
+#endif /* _RECORD_H */
@@ -5,6 +5,14 @@
 #include <SDL2/SDL.h>
 #include "terminal.h"
 #include "eia.h"
+#include "stats.h"
+#include "trace.h"
+#include "profile.h"
+#include "latency.h"
+#include "timer.h"
+#include "status.h"
+#include "raster.h"
+#include "paste.h"
 
 #ifdef COL_132
 #define SDLGUI_WIDTH 1452
@@ -13,10 +21,15 @@
 #endif
 #define SDLGUI_HEIGHT 240
 
-#define CHAR_WIDTH  11
-#define CHAR_HEIGHT 10
+#define CHAR_WIDTH  RASTER_CHAR_WIDTH
+#define CHAR_HEIGHT RASTER_CHAR_HEIGHT
 
-extern uint8_t _binary_char_rom_start[];
+/* The status row is kept below the emulated screen. */
+#define SDLGUI_TEXTURE_HEIGHT (SDLGUI_HEIGHT + CHAR_HEIGHT)
+#define SDLGUI_ROWS (SDLGUI_TEXTURE_HEIGHT / CHAR_HEIGHT)
+#define SDLGUI_COLS (SDLGUI_WIDTH / CHAR_WIDTH)
+#define SDLGUI_FRAME_US 16000
+#define SDLGUI_DRAWN_NONE 0xFFFFFFFF
 
 
 
@@ -25,8 +38,16 @@ static SDL_Renderer *sdlgui_renderer = NULL;
 static SDL_Texture *sdlgui_texture = NULL;
 static SDL_PixelFormat *sdlgui_pixel_format = NULL;
 static Uint32 *sdlgui_pixels = NULL;
-static int sdlgui_pixel_pitch = 0;
 static Uint32 sdlgui_ticks = 0;
+static bool sdlgui_status_shown = false;
+static bool sdlgui_present_needed = true;
+static raster_t sdlgui_raster;
+
+/* What each cell was last drawn as, and the columns drawn on each row
+   since the last upload. */
+static uint32_t sdlgui_drawn[SDLGUI_ROWS][SDLGUI_COLS];
+static int sdlgui_damage_left[SDLGUI_ROWS];
+static int sdlgui_damage_right[SDLGUI_ROWS];
 
 
 
@@ -36,9 +57,9 @@ static void sdlgui_exit_handler(void)
     SDL_FreeFormat(sdlgui_pixel_format);
   }
   if (sdlgui_texture != NULL) {
-    SDL_UnlockTexture(sdlgui_texture);
     SDL_DestroyTexture(sdlgui_texture);
   }
+  free(sdlgui_pixels);
   if (sdlgui_renderer != NULL) {
     SDL_DestroyRenderer(sdlgui_renderer);
   }
@@ -50,6 +71,28 @@ static void sdlgui_exit_handler(void)
 
 
 
+static void sdlgui_palette_init(void)
+{
+  /* Mapped once, instead of for every pixel. */
+  sdlgui_raster.palette[RASTER_SHADE_OFF] = SDL_MapRGB(sdlgui_pixel_format,
+    RASTER_LEVEL_OFF, RASTER_LEVEL_OFF, RASTER_LEVEL_OFF);
+  sdlgui_raster.palette[RASTER_SHADE_BOLD] = SDL_MapRGB(sdlgui_pixel_format,
+    RASTER_LEVEL_BOLD, RASTER_LEVEL_BOLD, RASTER_LEVEL_BOLD);
+  sdlgui_raster.palette[RASTER_SHADE_ON] = SDL_MapRGB(sdlgui_pixel_format,
+    RASTER_LEVEL_ON, RASTER_LEVEL_ON, RASTER_LEVEL_ON);
+  sdlgui_raster.pitch = SDLGUI_WIDTH;
+
+  for (int row = 0; row < SDLGUI_ROWS; row++) {
+    for (int col = 0; col < SDLGUI_COLS; col++) {
+      sdlgui_drawn[row][col] = SDLGUI_DRAWN_NONE;
+    }
+    sdlgui_damage_left[row] = SDLGUI_COLS;
+    sdlgui_damage_right[row] = -1;
+  }
+}
+
+
+
 int sdlgui_init(void)
 {
   if (SDL_Init(SDL_INIT_VIDEO) != 0) {
@@ -72,14 +115,15 @@ int sdlgui_init(void)
 
   if ((sdlgui_texture = SDL_CreateTexture(sdlgui_renderer, 
     SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
-    SDLGUI_WIDTH, SDLGUI_HEIGHT)) == NULL) {
+    SDLGUI_WIDTH, SDLGUI_TEXTURE_HEIGHT)) == NULL) {
     fprintf(stderr, "Unable to create texture: %s\n", SDL_GetError());
     return -1;
   }
 
-  if (SDL_LockTexture(sdlgui_texture, NULL,
-    (void **)&sdlgui_pixels, &sdlgui_pixel_pitch) != 0) {
-    fprintf(stderr, "Unable to lock texture: %s\n", SDL_GetError());
+  /* Rasterized here, and only the damaged parts go to the texture. */
+  sdlgui_pixels = calloc(SDLGUI_WIDTH * SDLGUI_TEXTURE_HEIGHT, sizeof(Uint32));
+  if (sdlgui_pixels == NULL) {
+    fprintf(stderr, "Unable to allocate pixels\n");
     return -1;
   }
 
@@ -88,188 +132,273 @@ int sdlgui_init(void)
     fprintf(stderr, "Unable to create pixel format: %s\n", SDL_GetError());
     return -1;
   }
+  sdlgui_palette_init();
 
   return 0;
 }
 
 
 
-static inline void sdlgui_set_pixel(uint16_t y, uint16_t x, uint8_t shade)
+static inline bool sdlgui_char(uint8_t row, uint8_t col, terminal_char_t c)
 {
-  sdlgui_pixels[(y * SDLGUI_WIDTH) + x] = 
-    SDL_MapRGB(sdlgui_pixel_format, shade, shade, shade);
+  bool blink_off = ((sdlgui_ticks % 1000) > 500);
+  uint32_t drawn;
+
+  /* Blinking cells are always reported as changed, but only look
+     different twice a second. */
+  drawn = c.byte | (c.attribute << 8);
+  if ((c.attribute >> TERMINAL_ATTRIBUTE_BLINK) & 0x1) {
+    drawn |= (blink_off << 16);
+  }
+  if (drawn == sdlgui_drawn[row][col]) {
+    return false;
+  }
+  sdlgui_drawn[row][col] = drawn;
+
+  sdlgui_raster.pixels = sdlgui_pixels;
+  sdlgui_raster.blink_off = blink_off;
+  raster_char(&sdlgui_raster, row, col, c);
+
+  if (col < sdlgui_damage_left[row]) {
+    sdlgui_damage_left[row] = col;
+  }
+  if (col > sdlgui_damage_right[row]) {
+    sdlgui_damage_right[row] = col;
+  }
+  return true;
 }
 
 
 
-static inline uint8_t sdlgui_shade(bool on, terminal_char_t c)
+static int sdlgui_upload(void)
 {
-  if (on ^ ((c.attribute >> TERMINAL_ATTRIBUTE_REVERSE) & 0x1)) {
-    if (((c.attribute >> TERMINAL_ATTRIBUTE_BLINK) & 0x1) && 
-      ((sdlgui_ticks % 1000) > 500)) {
-      return 0x0;
-    } else {
-      if ((c.attribute >> TERMINAL_ATTRIBUTE_BOLD) & 0x1) {
-        return 0x7F;
+  SDL_Rect rect;
+  int top = -1, left = 0, right = 0;
+  int uploaded = 0;
+
+  /* Damaged rows next to each other go up as one rectangle, as wide as
+     the widest of them. */
+  for (int row = 0; row <= SDLGUI_ROWS; row++) {
+    if (row < SDLGUI_ROWS && sdlgui_damage_right[row] >= 0) {
+      if (top == -1) {
+        top = row;
+        left = sdlgui_damage_left[row];
+        right = sdlgui_damage_right[row];
       } else {
-        return 0xFF;
+        left = (sdlgui_damage_left[row] < left) ?
+          sdlgui_damage_left[row] : left;
+        right = (sdlgui_damage_right[row] > right) ?
+          sdlgui_damage_right[row] : right;
       }
+      sdlgui_damage_left[row] = SDLGUI_COLS;
+      sdlgui_damage_right[row] = -1;
+      continue;
     }
-  } else {
-    if (((c.attribute >> TERMINAL_ATTRIBUTE_REVERSE) & 0x1) &&
-      (((c.attribute >> TERMINAL_ATTRIBUTE_BLINK) & 0x1) && 
-      ((sdlgui_ticks % 1000) > 500))) {
-      if ((c.attribute >> TERMINAL_ATTRIBUTE_BOLD) & 0x1) {
-        return 0x7F;
-      } else {
-        return 0xFF;
-      }
-    } else {
-      return 0x0;
+    if (top == -1) {
+      continue;
     }
+
+    rect.x = left * CHAR_WIDTH;
+    rect.y = top * CHAR_HEIGHT;
+    rect.w = (right - left + 1) * CHAR_WIDTH;
+    rect.h = (row - top) * CHAR_HEIGHT;
+    SDL_UpdateTexture(sdlgui_texture, &rect,
+      &sdlgui_pixels[(rect.y * SDLGUI_WIDTH) + rect.x],
+      SDLGUI_WIDTH * sizeof(Uint32));
+    uploaded++;
+    top = -1;
   }
+  return uploaded;
 }
 
 
 
-static inline void sdlgui_char(uint8_t row, uint8_t col, terminal_char_t c)
+static void sdlgui_status(void)
 {
-  int y, x;
-  uint8_t char_data;
-  int offset;
-  bool on;
-
-  for (y = 0; y < CHAR_HEIGHT; y++) {
-    offset = (c.byte * CHAR_HEIGHT * 2) + (y * 2);
-
-    char_data = _binary_char_rom_start[offset];
-    for (x = 0; x < 8; x++) {
-      if (((c.attribute >> TERMINAL_ATTRIBUTE_UNDERLINE) & 0x1)
-        && y == (CHAR_HEIGHT - 1)) {
-        on = true;
-      } else {
-        on = (char_data >> x) & 0x1;
-      }
-      sdlgui_set_pixel((row * CHAR_HEIGHT) + y,
-        (col * CHAR_WIDTH) + (7 - x),
-        sdlgui_shade(on, c));
-    }
+  char text[STATUS_COLS + 1];
+  terminal_char_t c;
+  int col;
+
+  if (status_visible != sdlgui_status_shown) {
+    sdlgui_status_shown = status_visible;
+    SDL_SetWindowSize(sdlgui_window, SDLGUI_WIDTH,
+      (sdlgui_status_shown) ? SDLGUI_TEXTURE_HEIGHT : SDLGUI_HEIGHT);
+    sdlgui_present_needed = true;
+  }
 
-    char_data = _binary_char_rom_start[offset + 1];
-    for (x = 0; x < 3; x++) {
-      if (((c.attribute >> TERMINAL_ATTRIBUTE_UNDERLINE) & 0x1)
-        && y == (CHAR_HEIGHT - 1)) {
-        on = true;
-      } else {
-        on = (char_data >> x) & 0x1;
-      }
-      sdlgui_set_pixel((row * CHAR_HEIGHT) + y,
-        (col * CHAR_WIDTH) + (2 - x) + 8,
-        sdlgui_shade(on, c));
+  if (! sdlgui_status_shown) {
+    return;
+  }
+
+  if (status_refresh(text)) {
+    c.attribute = (0x1 << TERMINAL_ATTRIBUTE_REVERSE);
+    for (col = 0; col < (SDLGUI_WIDTH / CHAR_WIDTH); col++) {
+      c.byte = (col < STATUS_COLS) ? text[col] : ' ';
+      sdlgui_char(SDLGUI_HEIGHT / CHAR_HEIGHT, col, c);
     }
   }
 }
 
 
 
+static size_t sdlgui_cursor_key(uint8_t *text, uint8_t final)
+{
+  size_t len = 0;
+
+  text[len++] = 0x1B;
+  if (terminal_cursor_key_code() != 0) {
+    text[len++] = terminal_cursor_key_code();
+  }
+  text[len++] = final;
+  return len;
+}
+
+
+
 void sdlgui_update(void)
 {
   int row, col;
+  int cells = 0;
+  uint32_t start, wait;
   SDL_Event event;
+  uint8_t text[sizeof(event.text.text)];
+  size_t len;
+  char *clipboard;
+  SDL_Rect source;
+
+  start = profile_pass_start();
 
   while (SDL_PollEvent(&event) == 1) {
+    len = 0;
     switch (event.type) {
     case SDL_QUIT:
       exit(0);
       break;
 
+    case SDL_WINDOWEVENT:
+      sdlgui_present_needed = true; /* Exposed, resized or moved. */
+      break;
+
     case SDL_TEXTINPUT:
-      eia_send(event.text.text[0] & 0xFF);
+      /* UTF-8, and a compose or input method may give several at once. */
+      len = paste_utf8_decode(event.text.text, text, sizeof(text));
+      for (size_t i = 0; i < len; i++) {
+        terminal_predict(text[i]); /* Queued before a fast echo is back. */
+      }
       break;
 
     case SDL_KEYDOWN:
       switch (event.key.keysym.sym) {
       case SDLK_RETURN:
-        eia_send('\n');
+        text[len++] = '\n';
         break;
 
       case SDLK_ESCAPE:
-        eia_send(0x1B);
+        text[len++] = 0x1B;
         break;
 
       case SDLK_BACKSPACE:
-        eia_send(0x08);
+        text[len++] = 0x08;
         break;
 
       case SDLK_TAB:
-        eia_send(0x09);
+        text[len++] = 0x09;
         break;
 
-      case SDLK_UP:
-        eia_send(0x1B);
-        if (terminal_cursor_key_code() != 0) {
-          eia_send(terminal_cursor_key_code());
+      case SDLK_SCROLLLOCK:
+        status_toggle();
+        break;
+
+      case SDLK_PRINTSCREEN:
+        trace_request();
+        break;
+
+      case SDLK_PAUSE:
+        terminal_predict_toggle();
+        break;
+
+      case SDLK_INSERT:
+        if ((event.key.keysym.mod & KMOD_SHIFT) && SDL_HasClipboardText()) {
+          clipboard = SDL_GetClipboardText();
+          if (clipboard != NULL) {
+            paste_start(clipboard);
+            SDL_free(clipboard);
+          }
         }
-        eia_send('A');
+        break;
+
+      case SDLK_UP:
+        len = sdlgui_cursor_key(text, 'A');
         break;
 
       case SDLK_LEFT:
-        eia_send(0x1B);
-        if (terminal_cursor_key_code() != 0) {
-          eia_send(terminal_cursor_key_code());
-        }
-        eia_send('D');
+        len = sdlgui_cursor_key(text, 'D');
         break;
 
       case SDLK_DOWN:
-        eia_send(0x1B);
-        if (terminal_cursor_key_code() != 0) {
-          eia_send(terminal_cursor_key_code());
-        }
-        eia_send('B');
+        len = sdlgui_cursor_key(text, 'B');
         break;
 
       case SDLK_RIGHT:
-        eia_send(0x1B);
-        if (terminal_cursor_key_code() != 0) {
-          eia_send(terminal_cursor_key_code());
-        }
-        eia_send('C');
+        len = sdlgui_cursor_key(text, 'C');
         break;
       }
       break;
     }
-  }
-
-  if (sdlgui_renderer != NULL) {
-    SDL_UnlockTexture(sdlgui_texture);
-
-    SDL_RenderCopy(sdlgui_renderer, sdlgui_texture, NULL, NULL);
 
-    if (SDL_LockTexture(sdlgui_texture, NULL,
-      (void **)&sdlgui_pixels, &sdlgui_pixel_pitch) != 0) {
-      fprintf(stderr, "Unable to lock texture: %s\n", SDL_GetError());
-      exit(0);
+    /* The key is taken before its bytes go out, or a fast echo could
+       arrive first. Back-dated to when SDL queued it, in milliseconds. */
+    if (len > 0) {
+      latency_key(timer_us() -
+        ((SDL_GetTicks() - event.common.timestamp) * 1000));
+      for (size_t i = 0; i < len; i++) {
+        eia_send(text[i]);
+      }
     }
   }
 
   /* Force 60 Hz (NTSC) */
+  wait = timer_us();
   while ((SDL_GetTicks() - sdlgui_ticks) < 16) {
     SDL_Delay(1);
   }
+  wait = timer_us() - wait;
 
+  latency_pass_start();
+
+  trace(TRACE_RENDER_START, 0, 0);
   for (row = 0; row < (SDLGUI_HEIGHT / CHAR_HEIGHT); row++) {
     for (col = 0; col < (SDLGUI_WIDTH / CHAR_WIDTH); col++) {
-      if (terminal_char_changed(row, col)) {
-        sdlgui_char(row, col, terminal_char_get(row, col));
+      if (terminal_char_changed(row, col) &&
+          sdlgui_char(row, col, terminal_char_get(row, col))) {
+        cells++;
       }
     }
   }
 
-  if (sdlgui_renderer != NULL) {
+  stats_count(STATS_RENDER_PASSES);
+  stats_count_add(STATS_CELLS_RENDERED, cells);
+  stats_peak_update(STATS_PEAK_CELLS_PER_PASS, cells);
+  trace(TRACE_RENDER_END, 0, cells);
+
+  sdlgui_status();
+
+  /* Nothing is copied or presented when nothing looks different. */
+  if (sdlgui_renderer != NULL &&
+      (sdlgui_upload() > 0 || sdlgui_present_needed)) {
+    source.x = 0;
+    source.y = 0;
+    source.w = SDLGUI_WIDTH;
+    source.h = (sdlgui_status_shown) ? SDLGUI_TEXTURE_HEIGHT : SDLGUI_HEIGHT;
+    SDL_RenderCopy(sdlgui_renderer, sdlgui_texture, &source, NULL);
     SDL_RenderPresent(sdlgui_renderer);
+    sdlgui_present_needed = false;
   }
 
+  /* The pacing delay is not counted, only the work done in the frame. */
+  profile_pass_end(start + wait, cells, SDLGUI_FRAME_US);
+  latency_pass_end();
+
   sdlgui_ticks = SDL_GetTicks();
 }
 
@@ -0,0 +1,209 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <signal.h>
+#include <unistd.h>
+#include "session.h"
+#include "eia.h"
+#include "diag.h"
+#include "stats.h"
+#include "trace.h"
+#include "profile.h"
+#include "record.h"
+#include "loopback.h"
+#include "pty.h"
+#include "shmexport.h"
+
+#define SESSION_REPLAY_IDLE_US 100000
+
+static volatile sig_atomic_t session_dump_requested = 0;
+
+
+
+static void session_sig_handler(int sig)
+{
+  (void)sig;
+  session_dump_requested = 1;
+}
+
+
+
+void session_put_stderr(uint8_t c)
+{
+  fputc(c, stderr);
+}
+
+
+
+void session_defaults(session_t *session)
+{
+  session->device = EIA_DEVICE_DEFAULT;
+  session->baud = EIA_BAUD_DEFAULT;
+  session->flow = EIA_FLOW_NONE;
+  session->command = NULL;
+  session->pty = false;
+  session->record_path = NULL;
+  session->replay_path = NULL;
+  session->replay_speed = 1.0;
+  session->loopback_delay = -1;
+  session->shm_name = NULL;
+}
+
+
+
+int session_option(session_t *session, int option, char *arg)
+{
+  switch (option) {
+  case 'd':
+    session->device = arg;
+    break;
+
+  case 'b':
+    session->baud = atol(arg);
+    break;
+
+  case 'f':
+    session->flow = eia_flow_parse(arg);
+    if (session->flow == -1) {
+      return -1;
+    }
+    break;
+
+  case 'e':
+    session->command = arg;
+    session->pty = true;
+    break;
+
+  case 'x':
+    session->pty = true;
+    break;
+
+  case 'r':
+    session->record_path = arg;
+    break;
+
+  case 'p':
+    session->replay_path = arg;
+    break;
+
+  case 's':
+    session->replay_speed = atof(arg);
+    break;
+
+  case 'l':
+    session->loopback_delay = atoi(arg);
+    break;
+
+  case 'm':
+    session->shm_name = arg;
+    break;
+
+  case 't':
+    trace_enabled = true;
+    break;
+
+  default:
+    return -1;
+  }
+  return 0;
+}
+
+
+
+void session_help(void)
+{
+  fprintf(stdout,
+     "  -d DEVICE Serial device, " EIA_DEVICE_DEFAULT " by default.\n"
+     "  -b BAUD   Serial baud rate, up to 4000000.\n"
+     "  -f FLOW   Serial flow control, none, xon or rts.\n"
+     "  -e CMD    Run CMD on a pseudo-terminal instead of the serial port.\n"
+     "  -x        Run the login shell on a pseudo-terminal.\n"
+     "  -r FILE   Record the session to FILE.\n"
+     "  -p FILE   Play back a recording instead of using the serial port.\n"
+     "  -s SPEED  Playback speed multiplier, 0 for as fast as possible.\n"
+     "  -l DELAY  Loopback host echoing after DELAY microseconds.\n"
+     "  -m NAME   Export the screen in shared memory, e.g. " SHMEXPORT_NAME ".\n"
+     "  -t        Keep the event trace ring, for dumps on SIGUSR1.\n");
+}
+
+
+
+int session_open(session_t *session)
+{
+  int fd;
+  struct sigaction sa;
+
+  if (session->replay_path != NULL) {
+    if (replay_open(session->replay_path, session->replay_speed) != 0) {
+      return -1;
+    }
+  } else if (session->loopback_delay >= 0) {
+    fd = loopback_open(session->loopback_delay);
+    if (fd == -1) {
+      return -1;
+    }
+    eia_init_fd(fd);
+  } else if (session->pty) {
+    fd = pty_open(session->command);
+    if (fd == -1) {
+      return -1;
+    }
+    eia_init_fd(fd);
+  } else {
+    if (eia_init_tty(session->device, session->baud, session->flow) != 0) {
+      return -1;
+    }
+  }
+  if (session->record_path != NULL) {
+    if (record_open(session->record_path) != 0) {
+      return -1;
+    }
+  }
+  if (session->shm_name != NULL) {
+    if (shmexport_open(session->shm_name) != 0) {
+      return -1;
+    }
+  }
+
+  diag_register(DIAG_STATS, "stats", stats_report);
+  diag_register(DIAG_TRACE, "trace", trace_report);
+  diag_register(DIAG_PROFILE, "profile", profile_report);
+
+  /* No SA_RESTART, so a blocking read returns and the dump happens. */
+  sa.sa_handler = session_sig_handler;
+  sigemptyset(&sa.sa_mask);
+  sa.sa_flags = 0;
+  sigaction(SIGUSR1, &sa, NULL);
+  return 0;
+}
+
+
+
+int session_run(session_t *session)
+{
+  /* Only returns when the other end has gone away. */
+  while (1) {
+    if (session->replay_path != NULL) {
+      if (! replay_update()) {
+        usleep(SESSION_REPLAY_IDLE_US); /* Done, keep the screen shown. */
+      }
+    } else {
+      eia_update();
+      if (! eia_connected()) {
+        if (session->pty) {
+          return EXIT_SUCCESS; /* The program on the PTY has exited. */
+        }
+        fprintf(stderr, "Serial line hung up\n");
+        return EXIT_FAILURE;
+      }
+    }
+    if (session_dump_requested) {
+      session_dump_requested = 0;
+      diag_dump(session_put_stderr);
+    }
+  }
+}
+
+
+
@@ -0,0 +1,32 @@
+#ifndef _SESSION_H
+#define _SESSION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* What the Linux front ends share: the options choosing the other end of
+   the line, which is a serial port, a program on a pseudo-terminal, the
+   loopback host or a recording, and the loop receiving from it. */
+#define SESSION_OPTIONS "d:b:f:e:xr:p:s:l:m:t"
+
+typedef struct session_s {
+  char *device;
+  long baud;
+  int flow;
+  char *command;
+  bool pty;
+  char *record_path;
+  char *replay_path;
+  double replay_speed;
+  int loopback_delay;
+  char *shm_name;
+} session_t;
+
+void session_defaults(session_t *session);
+int session_option(session_t *session, int option, char *arg);
+void session_help(void);
+int session_open(session_t *session);
+int session_run(session_t *session);
+void session_put_stderr(uint8_t c);
+
+#endif /* _SESSION_H */
@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "shmexport.h"
+#include "terminal.h"
+
+static shmexport_t *shmexport = NULL;
+static const char *shmexport_name = NULL;
+
+
+
+static void shmexport_exit_handler(void)
+{
+  shm_unlink(shmexport_name);
+}
+
+
+
+int shmexport_open(const char *name)
+{
+  int fd;
+
+  fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) {
+    fprintf(stderr, "shm_open() of %s failed with errno: %d\n", name, errno);
+    return -1;
+  }
+  if (ftruncate(fd, sizeof(shmexport_t)) == -1) {
+    fprintf(stderr, "ftruncate() failed with errno: %d\n", errno);
+    close(fd);
+    return -1;
+  }
+  shmexport = mmap(NULL, sizeof(shmexport_t), PROT_READ | PROT_WRITE,
+    MAP_SHARED, fd, 0);
+  close(fd);
+  if (shmexport == MAP_FAILED) {
+    fprintf(stderr, "mmap() failed with errno: %d\n", errno);
+    shmexport = NULL;
+    return -1;
+  }
+
+  shmexport_name = name;
+  atexit(shmexport_exit_handler);
+
+  /* Readers check the magic last, once the rest is valid. */
+  memset(shmexport, 0, sizeof(shmexport_t));
+  shmexport->version = SHMEXPORT_VERSION;
+  shmexport->rows = SHMEXPORT_ROWS;
+  __atomic_store_n(&shmexport->magic, SHMEXPORT_MAGIC, __ATOMIC_RELEASE);
+  return 0;
+}
+
+
+
+void shmexport_update(void)
+{
+  terminal_char_t c;
+  uint8_t row, col, cols;
+  bool changed = false;
+
+  if (shmexport == NULL) {
+    return;
+  }
+
+  /* The segment is only ever written from here, so comparing against it
+     needs no locking, and unchanged passes leave readers undisturbed. */
+  terminal_cursor_get(&row, &col);
+  cols = terminal_columns();
+  if (row != shmexport->cursor_row || col != shmexport->cursor_col ||
+      cols != shmexport->cols) {
+    changed = true;
+  }
+  for (row = 0; row < SHMEXPORT_ROWS && ! changed; row++) {
+    for (col = 0; col < SHMEXPORT_COLS; col++) {
+      c = (col < cols) ? terminal_char_peek(row, col) :
+        (terminal_char_t){ ' ', 0 };
+      if (c.byte != shmexport->cell[row][col].byte ||
+          c.attribute != shmexport->cell[row][col].attribute) {
+        changed = true;
+        break;
+      }
+    }
+  }
+  if (! changed) {
+    return;
+  }
+
+  __atomic_store_n(&shmexport->sequence, shmexport->sequence + 1,
+    __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  terminal_cursor_get(&shmexport->cursor_row, &shmexport->cursor_col);
+  shmexport->cols = cols;
+  for (row = 0; row < SHMEXPORT_ROWS; row++) {
+    for (col = 0; col < SHMEXPORT_COLS; col++) {
+      shmexport->cell[row][col] = (col < cols) ?
+        terminal_char_peek(row, col) : (terminal_char_t){ ' ', 0 };
+    }
+  }
+  shmexport->generation++;
+
+  __atomic_store_n(&shmexport->sequence, shmexport->sequence + 1,
+    __ATOMIC_RELEASE);
+}
+
+
+
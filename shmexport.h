@@ -0,0 +1,55 @@
+#ifndef _SHMEXPORT_H
+#define _SHMEXPORT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "terminal.h"
+
+/* Layout of the shared memory segment, all fields in host byte order.
+   The cells are the byte and attribute of each position as shown, with
+   the attribute bits numbered by TERMINAL_ATTRIBUTE_*, and the cursor
+   cell has reverse and blink set. Columns beyond "cols" are blank.
+
+   The writer makes "sequence" odd while it changes anything and even
+   again when done. A reader takes "sequence", waits if it is odd, reads
+   what it needs, then takes "sequence" again, and reads again if it has
+   changed. "generation" counts the updates that changed something. */
+#define SHMEXPORT_NAME "/terminominal"
+#define SHMEXPORT_MAGIC 0x4D4E4D54 /* "TMNM" */
+#define SHMEXPORT_VERSION 1
+#define SHMEXPORT_ROWS 24
+#define SHMEXPORT_COLS 132
+
+typedef struct shmexport_s {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t sequence;
+  uint32_t generation;
+  uint8_t rows;
+  uint8_t cols;
+  uint8_t cursor_row;
+  uint8_t cursor_col;
+  terminal_char_t cell[SHMEXPORT_ROWS][SHMEXPORT_COLS];
+} shmexport_t;
+
+static inline uint32_t shmexport_read_begin(const shmexport_t *shm)
+{
+  uint32_t sequence;
+
+  while ((sequence = __atomic_load_n(&shm->sequence, __ATOMIC_ACQUIRE)) & 1) {
+    ; /* Being written. */
+  }
+  return sequence;
+}
+
+static inline bool shmexport_read_retry(const shmexport_t *shm,
+  uint32_t sequence)
+{
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  return __atomic_load_n(&shm->sequence, __ATOMIC_RELAXED) != sequence;
+}
+
+int shmexport_open(const char *name);
+void shmexport_update(void);
+
+#endif /* _SHMEXPORT_H */
@@ -0,0 +1,48 @@
+#ifndef _HARDWARE_DMA_H
+#define _HARDWARE_DMA_H
+
+#include "pico/stdlib.h"
+
+#define DMA_SIM_CHANNEL_MAX 12
+
+enum dma_channel_transfer_size {
+  DMA_SIZE_8 = 0,
+  DMA_SIZE_16 = 1,
+  DMA_SIZE_32 = 2,
+};
+
+enum dma_channel_transfer_dreq {
+  DREQ_PIO0_TX0 = 0,
+};
+
+typedef struct dma_channel_config_s {
+  uint32_t ctrl;
+} dma_channel_config;
+
+typedef struct dma_channel_hw_s {
+  volatile const void *read_addr;
+  volatile void *write_addr;
+  volatile uint32_t transfer_count;
+  volatile uint32_t ctrl_trig;
+} dma_channel_hw_t;
+
+typedef struct dma_hw_s {
+  dma_channel_hw_t ch[DMA_SIM_CHANNEL_MAX];
+} dma_hw_t;
+
+extern dma_hw_t dma_sim_hw;
+#define dma_hw (&dma_sim_hw)
+
+dma_channel_config dma_channel_get_default_config(uint channel);
+void channel_config_set_transfer_data_size(dma_channel_config *c,
+  enum dma_channel_transfer_size size);
+void channel_config_set_read_increment(dma_channel_config *c, bool incr);
+void channel_config_set_write_increment(dma_channel_config *c, bool incr);
+void channel_config_set_dreq(dma_channel_config *c, uint dreq);
+void channel_config_set_chain_to(dma_channel_config *c, uint chain_to);
+void dma_channel_configure(uint channel, const dma_channel_config *config,
+  volatile void *write_addr, const volatile void *read_addr,
+  uint transfer_count, bool trigger);
+void dma_channel_start(uint channel);
+
+#endif /* _HARDWARE_DMA_H */
@@ -0,0 +1,24 @@
+#ifndef _HARDWARE_IRQ_H
+#define _HARDWARE_IRQ_H
+
+#include "pico/stdlib.h"
+
+#define IRQ_SIM_MAX 32
+
+enum irq_number {
+  PIO0_IRQ_0 = 7,
+  PIO0_IRQ_1 = 8,
+  PIO1_IRQ_0 = 9,
+  PIO1_IRQ_1 = 10,
+  UART0_IRQ = 20,
+  UART1_IRQ = 21,
+};
+
+typedef void (*irq_handler_t)(void);
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_set_enabled(uint num, bool enabled);
+
+void irq_sim_raise(uint num);
+
+#endif /* _HARDWARE_IRQ_H */
@@ -0,0 +1,64 @@
+#ifndef _HARDWARE_PIO_H
+#define _HARDWARE_PIO_H
+
+#include "pico/stdlib.h"
+
+#define PIO_SIM_SM_MAX 4
+
+typedef struct pio_hw_s {
+  volatile uint32_t txf[PIO_SIM_SM_MAX];
+  volatile uint32_t rxf[PIO_SIM_SM_MAX];
+} pio_hw_t;
+
+typedef pio_hw_t *PIO;
+
+typedef struct pio_program_s {
+  const uint16_t *instructions;
+  uint8_t length;
+  int8_t origin;
+} pio_program_t;
+
+typedef struct pio_sm_config_s {
+  uint32_t clkdiv;
+  uint32_t execctrl;
+  uint32_t shiftctrl;
+  uint32_t pinctrl;
+} pio_sm_config;
+
+enum pio_fifo_join {
+  PIO_FIFO_JOIN_NONE = 0,
+  PIO_FIFO_JOIN_TX = 1,
+  PIO_FIFO_JOIN_RX = 2,
+};
+
+enum pio_interrupt_source {
+  pis_interrupt0 = 8,
+};
+
+extern pio_hw_t pio_sim_hw[2];
+#define pio0 (&pio_sim_hw[0])
+#define pio1 (&pio_sim_hw[1])
+
+uint pio_claim_unused_sm(PIO pio, bool required);
+uint pio_add_program(PIO pio, const pio_program_t *program);
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config);
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+void pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base,
+  uint pin_count, bool is_out);
+void pio_gpio_init(PIO pio, uint pin);
+uint32_t pio_sm_get(PIO pio, uint sm);
+void pio_interrupt_clear(PIO pio, uint irq);
+void pio_set_irq0_source_enabled(PIO pio, enum pio_interrupt_source source,
+  bool enabled);
+
+void sm_config_set_out_shift(pio_sm_config *c, bool shift_right,
+  bool autopull, uint pull_threshold);
+void sm_config_set_in_shift(pio_sm_config *c, bool shift_right,
+  bool autopush, uint push_threshold);
+void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join);
+void sm_config_set_out_pins(pio_sm_config *c, uint out_base, uint out_count);
+void sm_config_set_in_pins(pio_sm_config *c, uint in_base);
+void sm_config_set_clkdiv(pio_sm_config *c, float div);
+pio_sm_config pio_get_default_sm_config(void);
+
+#endif /* _HARDWARE_PIO_H */
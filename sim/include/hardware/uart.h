@@ -0,0 +1,55 @@
+#ifndef _HARDWARE_UART_H
+#define _HARDWARE_UART_H
+
+#include "pico/stdlib.h"
+
+#define UART_SIM_FIFO_SIZE 32
+
+#define UART_UARTRSR_OE_BITS 0x00000008
+#define UART_UARTCR_LBE_BITS 0x00000080
+
+typedef enum {
+  UART_PARITY_NONE,
+  UART_PARITY_EVEN,
+  UART_PARITY_ODD,
+} uart_parity_t;
+
+typedef struct uart_hw_s {
+  volatile uint32_t rsr;
+  volatile uint32_t cr;
+} uart_hw_t;
+
+/* Receive FIFO filled by the simulator, transmitted bytes are captured. */
+typedef struct uart_sim_s {
+  uart_hw_t hw;
+  uint8_t rx[UART_SIM_FIFO_SIZE];
+  int rx_head;
+  int rx_count;
+  void (*tx)(uint8_t c);
+} uart_inst_t;
+
+extern uart_inst_t uart_sim[2];
+#define uart0 (&uart_sim[0])
+#define uart1 (&uart_sim[1])
+
+static inline void hw_set_bits(volatile uint32_t *addr, uint32_t mask)
+{
+  *addr |= mask;
+}
+
+static inline uart_hw_t *uart_get_hw(uart_inst_t *uart)
+{
+  return &uart->hw;
+}
+
+uint uart_init(uart_inst_t *uart, uint baudrate);
+void uart_set_format(uart_inst_t *uart, uint data_bits, uint stop_bits,
+  uart_parity_t parity);
+void uart_set_fifo_enabled(uart_inst_t *uart, bool enabled);
+void uart_putc(uart_inst_t *uart, char c);
+bool uart_is_readable(uart_inst_t *uart);
+char uart_getc(uart_inst_t *uart);
+
+bool uart_sim_receive(uart_inst_t *uart, uint8_t c);
+
+#endif /* _HARDWARE_UART_H */
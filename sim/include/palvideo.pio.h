@@ -0,0 +1,35 @@
+#ifndef _PALVIDEO_PIO_H
+#define _PALVIDEO_PIO_H
+
+/* Host stand-in for the header generated from palvideo.pio. */
+
+#include "hardware/pio.h"
+#include "hardware/clocks.h"
+
+static const uint16_t palvideo_program_instructions[] = {
+  0x80a0, /* pull block */
+  0x6002, /* out pins, 2 */
+  0x00e1, /* jmp !osre, 1 */
+};
+
+static const pio_program_t palvideo_program = {
+  .instructions = palvideo_program_instructions,
+  .length = 3,
+  .origin = -1,
+};
+
+static inline void palvideo_program_init(PIO pio, uint sm, uint offset)
+{
+  pio_sm_config c = pio_get_default_sm_config();
+  sm_config_set_out_shift(&c, false, true, 32);
+  sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+  sm_config_set_out_pins(&c, 16, 2);
+  pio_gpio_init(pio, 16);
+  pio_gpio_init(pio, 17);
+  pio_sm_set_consecutive_pindirs(pio, sm, 16, 2, true);
+  sm_config_set_clkdiv(&c, clock_get_hz(clk_sys) / 40000000.0);
+  pio_sm_init(pio, sm, offset, &c);
+  pio_sm_set_enabled(pio, sm, true);
+}
+
+#endif /* _PALVIDEO_PIO_H */
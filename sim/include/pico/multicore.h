@@ -0,0 +1,11 @@
+#ifndef _PICO_MULTICORE_H
+#define _PICO_MULTICORE_H
+
+#include "pico/stdlib.h"
+
+/* The simulator runs both cores' loops from one host thread. */
+
+void multicore_reset_core1(void);
+void multicore_launch_core1(void (*entry)(void));
+
+#endif /* _PICO_MULTICORE_H */
@@ -0,0 +1,26 @@
+#ifndef _PICO_STDLIB_H
+#define _PICO_STDLIB_H
+
+/* Host stand-in for the pico-sdk, see sim/pico_stub.c. */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef unsigned int uint;
+
+enum gpio_function {
+  GPIO_FUNC_UART = 2,
+  GPIO_FUNC_PIO0 = 6,
+  GPIO_FUNC_PIO1 = 7,
+};
+
+uint32_t time_us_32(void);
+uint64_t time_us_64(void);
+void busy_wait_us_32(uint32_t delay_us);
+void sleep_ms(uint32_t ms);
+
+void gpio_set_function(uint gpio, enum gpio_function fn);
+void gpio_pull_up(uint gpio);
+
+#endif /* _PICO_STDLIB_H */
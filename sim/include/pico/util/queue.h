@@ -0,0 +1,13 @@
+#ifndef _PICO_UTIL_QUEUE_H
+#define _PICO_UTIL_QUEUE_H
+
+#include "pico/stdlib.h"
+
+/* Host stand-in, nothing in the firmware uses the queue yet. */
+
+typedef struct {
+  uint element_size;
+  uint element_count;
+} queue_t;
+
+#endif /* _PICO_UTIL_QUEUE_H */
@@ -0,0 +1,48 @@
+#ifndef _PS2KBD_PIO_H
+#define _PS2KBD_PIO_H
+
+/* Host stand-in for the header generated from ps2kbd.pio. */
+
+#include "hardware/pio.h"
+
+static const uint16_t ps2kbd_program_instructions[] = {
+  0x2021, /* wait 0 pin 1 */
+  0x20a1, /* wait 1 pin 1 */
+  0xe028, /* set x, 8 */
+  0x2021, /* wait 0 pin 1 */
+  0x4001, /* in pins, 1 */
+  0x20a1, /* wait 1 pin 1 */
+  0x0043, /* jmp x-- 3 */
+  0x2021, /* wait 0 pin 1 */
+  0x20a1, /* wait 1 pin 1 */
+  0xc020, /* irq wait 0 */
+};
+
+static const pio_program_t ps2kbd_program = {
+  .instructions = ps2kbd_program_instructions,
+  .length = 10,
+  .origin = -1,
+};
+
+static inline pio_sm_config ps2kbd_program_get_default_config(uint offset)
+{
+  (void)offset;
+  return pio_get_default_sm_config();
+}
+
+static inline void ps2kbd_program_init(PIO pio, uint sm, uint offset)
+{
+  pio_sm_config c = ps2kbd_program_get_default_config(offset);
+  sm_config_set_in_shift(&c, true, true, 9); /* 8 Data Bits + Parity Bit */
+  sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_RX);
+  sm_config_set_in_pins(&c, 4);
+  pio_gpio_init(pio, 4);
+  pio_gpio_init(pio, 5);
+  pio_sm_set_consecutive_pindirs(pio, sm, 4, 2, false);
+  gpio_pull_up(4);
+  gpio_pull_up(5);
+  pio_sm_init(pio, sm, offset, &c);
+  pio_sm_set_enabled(pio, sm, true);
+}
+
+#endif /* _PS2KBD_PIO_H */
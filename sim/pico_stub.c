@@ -0,0 +1,403 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/uart.h"
+#include "hardware/irq.h"
+#include "pico/multicore.h"
+
+/* Host stand-ins for the parts of the pico-sdk used by the firmware. */
+
+#define SIM_CLK_SYS_HZ 125000000
+
+
+
+pio_hw_t pio_sim_hw[2];
+dma_hw_t dma_sim_hw;
+uart_inst_t uart_sim[2];
+
+static irq_handler_t irq_sim_handler[IRQ_SIM_MAX];
+static bool irq_sim_enabled[IRQ_SIM_MAX];
+
+static uint pio_sim_sm_used[2];
+static uint pio_sim_program_offset[2];
+
+
+
+uint64_t time_us_64(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+
+
+uint32_t time_us_32(void)
+{
+  return (uint32_t)time_us_64();
+}
+
+
+
+void busy_wait_us_32(uint32_t delay_us)
+{
+  uint32_t start = time_us_32();
+  while ((time_us_32() - start) < delay_us) {
+    ;
+  }
+}
+
+
+
+void sleep_ms(uint32_t ms)
+{
+  struct timespec ts;
+  ts.tv_sec = ms / 1000;
+  ts.tv_nsec = (ms % 1000) * 1000000;
+  nanosleep(&ts, NULL);
+}
+
+
+
+void gpio_set_function(uint gpio, enum gpio_function fn)
+{
+  (void)gpio;
+  (void)fn;
+}
+
+
+
+void gpio_pull_up(uint gpio)
+{
+  (void)gpio;
+}
+
+
+
+uint32_t clock_get_hz(enum clock_index clk_index)
+{
+  (void)clk_index;
+  return SIM_CLK_SYS_HZ;
+}
+
+
+
+static inline int pio_sim_index(PIO pio)
+{
+  return (pio == pio0) ? 0 : 1;
+}
+
+
+
+uint pio_claim_unused_sm(PIO pio, bool required)
+{
+  (void)required;
+  return pio_sim_sm_used[pio_sim_index(pio)]++ % PIO_SIM_SM_MAX;
+}
+
+
+
+uint pio_add_program(PIO pio, const pio_program_t *program)
+{
+  uint offset = pio_sim_program_offset[pio_sim_index(pio)];
+  pio_sim_program_offset[pio_sim_index(pio)] += program->length;
+  return offset;
+}
+
+
+
+void pio_sm_init(PIO pio, uint sm, uint initial_pc,
+  const pio_sm_config *config)
+{
+  (void)pio;
+  (void)sm;
+  (void)initial_pc;
+  (void)config;
+}
+
+
+
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled)
+{
+  (void)pio;
+  (void)sm;
+  (void)enabled;
+}
+
+
+
+void pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base,
+  uint pin_count, bool is_out)
+{
+  (void)pio;
+  (void)sm;
+  (void)pin_base;
+  (void)pin_count;
+  (void)is_out;
+}
+
+
+
+void pio_gpio_init(PIO pio, uint pin)
+{
+  (void)pio;
+  (void)pin;
+}
+
+
+
+uint32_t pio_sm_get(PIO pio, uint sm)
+{
+  return pio->rxf[sm];
+}
+
+
+
+void pio_interrupt_clear(PIO pio, uint irq)
+{
+  (void)pio;
+  (void)irq;
+}
+
+
+
+void pio_set_irq0_source_enabled(PIO pio, enum pio_interrupt_source source,
+  bool enabled)
+{
+  (void)pio;
+  (void)source;
+  (void)enabled;
+}
+
+
+
+pio_sm_config pio_get_default_sm_config(void)
+{
+  pio_sm_config c = { 0x10000, 0, 0, 0 };
+  return c;
+}
+
+
+
+void sm_config_set_out_shift(pio_sm_config *c, bool shift_right,
+  bool autopull, uint pull_threshold)
+{
+  c->shiftctrl = (shift_right << 19) | (autopull << 17) |
+    ((pull_threshold & 0x1F) << 25);
+}
+
+
+
+void sm_config_set_in_shift(pio_sm_config *c, bool shift_right,
+  bool autopush, uint push_threshold)
+{
+  c->shiftctrl = (shift_right << 18) | (autopush << 16) |
+    ((push_threshold & 0x1F) << 20);
+}
+
+
+
+void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join)
+{
+  c->shiftctrl |= (uint32_t)join << 30;
+}
+
+
+
+void sm_config_set_out_pins(pio_sm_config *c, uint out_base, uint out_count)
+{
+  c->pinctrl = (out_base & 0x1F) | ((out_count & 0x3F) << 20);
+}
+
+
+
+void sm_config_set_in_pins(pio_sm_config *c, uint in_base)
+{
+  c->pinctrl = (in_base & 0x1F) << 15;
+}
+
+
+
+void sm_config_set_clkdiv(pio_sm_config *c, float div)
+{
+  c->clkdiv = (uint32_t)(div * 256.0f) << 8;
+}
+
+
+
+dma_channel_config dma_channel_get_default_config(uint channel)
+{
+  dma_channel_config c = { channel << 11 };
+  return c;
+}
+
+
+
+void channel_config_set_transfer_data_size(dma_channel_config *c,
+  enum dma_channel_transfer_size size)
+{
+  c->ctrl = (c->ctrl & ~0xC) | (size << 2);
+}
+
+
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incr)
+{
+  c->ctrl = (c->ctrl & ~0x10) | (incr << 4);
+}
+
+
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incr)
+{
+  c->ctrl = (c->ctrl & ~0x20) | (incr << 5);
+}
+
+
+
+void channel_config_set_dreq(dma_channel_config *c, uint dreq)
+{
+  c->ctrl = (c->ctrl & ~(0x3F << 15)) | ((dreq & 0x3F) << 15);
+}
+
+
+
+void channel_config_set_chain_to(dma_channel_config *c, uint chain_to)
+{
+  c->ctrl = (c->ctrl & ~(0xF << 11)) | ((chain_to & 0xF) << 11);
+}
+
+
+
+void dma_channel_configure(uint channel, const dma_channel_config *config,
+  volatile void *write_addr, const volatile void *read_addr,
+  uint transfer_count, bool trigger)
+{
+  dma_sim_hw.ch[channel].read_addr = read_addr;
+  dma_sim_hw.ch[channel].write_addr = write_addr;
+  dma_sim_hw.ch[channel].transfer_count = transfer_count;
+  dma_sim_hw.ch[channel].ctrl_trig = config->ctrl | (trigger ? 1 : 0);
+}
+
+
+
+void dma_channel_start(uint channel)
+{
+  dma_sim_hw.ch[channel].ctrl_trig |= 1;
+}
+
+
+
+uint uart_init(uart_inst_t *uart, uint baudrate)
+{
+  uart->rx_head = 0;
+  uart->rx_count = 0;
+  return baudrate;
+}
+
+
+
+void uart_set_format(uart_inst_t *uart, uint data_bits, uint stop_bits,
+  uart_parity_t parity)
+{
+  (void)uart;
+  (void)data_bits;
+  (void)stop_bits;
+  (void)parity;
+}
+
+
+
+void uart_set_fifo_enabled(uart_inst_t *uart, bool enabled)
+{
+  (void)uart;
+  (void)enabled;
+}
+
+
+
+bool uart_sim_receive(uart_inst_t *uart, uint8_t c)
+{
+  /* A full FIFO overruns like the real one, the byte is lost. */
+  if (uart->rx_count >= UART_SIM_FIFO_SIZE) {
+    uart->hw.rsr |= UART_UARTRSR_OE_BITS;
+    return false;
+  }
+  uart->rx[(uart->rx_head + uart->rx_count) % UART_SIM_FIFO_SIZE] = c;
+  uart->rx_count++;
+  return true;
+}
+
+
+
+void uart_putc(uart_inst_t *uart, char c)
+{
+  if (uart->hw.cr & UART_UARTCR_LBE_BITS) {
+    uart_sim_receive(uart, c);
+  }
+  if (uart->tx != NULL) {
+    uart->tx(c);
+  }
+}
+
+
+
+bool uart_is_readable(uart_inst_t *uart)
+{
+  return uart->rx_count > 0;
+}
+
+
+
+char uart_getc(uart_inst_t *uart)
+{
+  char c;
+
+  c = uart->rx[uart->rx_head];
+  uart->rx_head = (uart->rx_head + 1) % UART_SIM_FIFO_SIZE;
+  uart->rx_count--;
+  return c;
+}
+
+
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler)
+{
+  irq_sim_handler[num] = handler;
+}
+
+
+
+void irq_set_enabled(uint num, bool enabled)
+{
+  irq_sim_enabled[num] = enabled;
+}
+
+
+
+void irq_sim_raise(uint num)
+{
+  if (irq_sim_enabled[num] && irq_sim_handler[num] != NULL) {
+    irq_sim_handler[num]();
+  }
+}
+
+
+
+void multicore_reset_core1(void)
+{
+}
+
+
+
+void multicore_launch_core1(void (*entry)(void))
+{
+  (void)entry;
+}
+
+
+
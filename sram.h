@@ -0,0 +1,13 @@
+#ifndef _SRAM_H
+#define _SRAM_H
+
+/* Functions on the render and receive paths, which can be run from SRAM
+   instead of flash through the XIP cache with the SRAM_HOT_PATHS option. */
+#ifdef SRAM_HOT_PATHS
+#include "pico/platform.h"
+#define SRAM_FUNC(name) __not_in_flash_func(name)
+#else
+#define SRAM_FUNC(name) name
+#endif /* SRAM_HOT_PATHS */
+
+#endif /* _SRAM_H */
@@ -0,0 +1,67 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "stats.h"
+#include "diag.h"
+
+uint32_t stats_counter[STATS_COUNTER_MAX];
+uint32_t stats_peak[STATS_PEAK_MAX];
+uint32_t stats_handled[STATS_SEQUENCE_MAX][128];
+uint32_t stats_unhandled[STATS_SEQUENCE_MAX][128];
+
+static const char *stats_counter_name[STATS_COUNTER_MAX] = {
+  "rx_bytes",
+  "tx_bytes",
+  "printable",
+  "control",
+  "escape",
+  "scrolls",
+  "cells_dirtied",
+  "uart_overruns",
+  "ps2_parity",
+  "render_passes",
+  "cells_rendered",
+  "predict_confirmed",
+  "predict_rolled_back",
+};
+
+static const char *stats_peak_name[STATS_PEAK_MAX] = {
+  "peak_rx_burst",
+  "peak_cells_per_pass",
+};
+
+static const char *stats_sequence_name[STATS_SEQUENCE_MAX] = {
+  "esc",
+  "csi",
+  "hash",
+};
+
+
+
+void stats_report(diag_put_t put)
+{
+  for (int i = 0; i < STATS_COUNTER_MAX; i++) {
+    diag_printf(put, "%s=%lu\n", stats_counter_name[i],
+      (unsigned long)stats_counter[i]);
+  }
+
+  for (int i = 0; i < STATS_PEAK_MAX; i++) {
+    diag_printf(put, "%s=%lu\n", stats_peak_name[i],
+      (unsigned long)stats_peak[i]);
+  }
+
+  /* Only sequences that have been seen, to keep the report short. */
+  for (int type = 0; type < STATS_SEQUENCE_MAX; type++) {
+    for (int final = 0; final < 128; final++) {
+      if (stats_handled[type][final] == 0 &&
+          stats_unhandled[type][final] == 0) {
+        continue;
+      }
+      diag_printf(put, "%s_%02x=%lu/%lu\n", stats_sequence_name[type], final,
+        (unsigned long)stats_handled[type][final],
+        (unsigned long)stats_unhandled[type][final]);
+    }
+  }
+}
+
+
+
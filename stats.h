@@ -0,0 +1,72 @@
+#ifndef _STATS_H
+#define _STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "diag.h"
+
+typedef enum {
+  STATS_RX_BYTES,
+  STATS_TX_BYTES,
+  STATS_PRINTABLE,
+  STATS_CONTROL,
+  STATS_ESCAPE,
+  STATS_SCROLLS,
+  STATS_CELLS_DIRTIED,
+  STATS_UART_OVERRUNS,
+  STATS_PS2_PARITY,
+  STATS_RENDER_PASSES,
+  STATS_CELLS_RENDERED,
+  STATS_PREDICT_CONFIRMED,
+  STATS_PREDICT_ROLLED_BACK,
+  STATS_COUNTER_MAX,
+} stats_counter_t;
+
+typedef enum {
+  STATS_PEAK_RX_BURST,
+  STATS_PEAK_CELLS_PER_PASS,
+  STATS_PEAK_MAX,
+} stats_peak_t;
+
+typedef enum {
+  STATS_SEQUENCE_ESC,
+  STATS_SEQUENCE_CSI,
+  STATS_SEQUENCE_HASH,
+  STATS_SEQUENCE_MAX,
+} stats_sequence_t;
+
+extern uint32_t stats_counter[STATS_COUNTER_MAX];
+extern uint32_t stats_peak[STATS_PEAK_MAX];
+extern uint32_t stats_handled[STATS_SEQUENCE_MAX][128];
+extern uint32_t stats_unhandled[STATS_SEQUENCE_MAX][128];
+
+static inline void stats_count(stats_counter_t counter)
+{
+  stats_counter[counter]++;
+}
+
+static inline void stats_count_add(stats_counter_t counter, uint32_t value)
+{
+  stats_counter[counter] += value;
+}
+
+static inline void stats_peak_update(stats_peak_t peak, uint32_t value)
+{
+  if (value > stats_peak[peak]) {
+    stats_peak[peak] = value;
+  }
+}
+
+static inline void stats_sequence(stats_sequence_t type, uint8_t final,
+  bool handled)
+{
+  if (handled) {
+    stats_handled[type][final & 0x7F]++;
+  } else {
+    stats_unhandled[type][final & 0x7F]++;
+  }
+}
+
+void stats_report(diag_put_t put);
+
+#endif /* _STATS_H */
@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "status.h"
+#include "stats.h"
+#include "timer.h"
+
+#define STATUS_INTERVAL_US 1000000
+#define STATUS_LINE_LEN 128
+
+volatile bool status_visible = false;
+
+static bool status_first = true;
+static uint32_t status_time;
+static uint32_t status_rx_bytes;
+static uint32_t status_render_passes;
+static uint32_t status_cells_rendered;
+
+
+
+void status_toggle(void)
+{
+  status_visible = ! status_visible;
+  status_first = true;
+}
+
+
+
+bool status_refresh(char text[STATUS_COLS + 1])
+{
+  uint32_t now, elapsed, rx, passes, cells;
+  char line[STATUS_LINE_LEN];
+
+  /* Rates are sampled once per second, the text only changes then. */
+  now = timer_us();
+  elapsed = now - status_time;
+  if (! status_first && elapsed < STATUS_INTERVAL_US) {
+    return false;
+  }
+
+  rx = stats_counter[STATS_RX_BYTES] - status_rx_bytes;
+  passes = stats_counter[STATS_RENDER_PASSES] - status_render_passes;
+  cells = stats_counter[STATS_CELLS_RENDERED] - status_cells_rendered;
+
+  status_time = now;
+  status_rx_bytes = stats_counter[STATS_RX_BYTES];
+  status_render_passes = stats_counter[STATS_RENDER_PASSES];
+  status_cells_rendered = stats_counter[STATS_CELLS_RENDERED];
+
+  if (status_first) {
+    status_first = false;
+    snprintf(line, STATUS_LINE_LEN, " Measuring...");
+  } else {
+    elapsed /= 1000; /* Milliseconds, to keep the products within 32 bits. */
+    snprintf(line, STATUS_LINE_LEN,
+      " RX %lu B/s | Render %lu/s, %lu cells | Parity %lu | RX peak %lu, overrun %lu",
+      (unsigned long)((rx * 1000) / elapsed),
+      (unsigned long)((passes * 1000) / elapsed),
+      (unsigned long)((passes > 0) ? (cells / passes) : 0),
+      (unsigned long)stats_counter[STATS_PS2_PARITY],
+      (unsigned long)stats_peak[STATS_PEAK_RX_BURST],
+      (unsigned long)stats_counter[STATS_UART_OVERRUNS]);
+  }
+
+  /* Cut or pad to the full width so old text is overwritten. */
+  memset(text, ' ', STATUS_COLS);
+  memcpy(text, line, (strlen(line) < STATUS_COLS) ? strlen(line) : STATUS_COLS);
+  text[STATUS_COLS] = '\0';
+
+  return true;
+}
+
+
+
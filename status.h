@@ -0,0 +1,13 @@
+#ifndef _STATUS_H
+#define _STATUS_H
+
+#include <stdbool.h>
+
+#define STATUS_COLS 80
+
+extern volatile bool status_visible;
+
+void status_toggle(void);
+bool status_refresh(char text[STATUS_COLS + 1]);
+
+#endif /* _STATUS_H */
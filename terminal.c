@@ -1,9 +1,15 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include "terminal.h"
 #include "eia.h"
-#include "error.h"
+#include "trace.h"
+#include "timer.h"
+#include "stats.h"
+#include "diag.h"
+#include "sram.h"
+#include "diffframe.h"
 
 #define PARAM_MAX 8
 #define PARAM_LEN 12
@@ -11,6 +17,9 @@
 #define ROW_MAX_HARD 24
 #define COL_MAX_HARD 132
 
+#define PREDICT_MAX 32
+#define PREDICT_TIMEOUT_US 1000000
+
 typedef enum {
   ESCAPE_NONE   = 0,
   ESCAPE_START  = 1,
@@ -18,12 +27,24 @@ typedef enum {
   ESCAPE_HASH   = 3,
   ESCAPE_G0_SET = 4,
   ESCAPE_G1_SET = 5,
+  ESCAPE_FRAME  = 6,
 } escape_t;
 
+typedef struct predict_s {
+  uint8_t row;
+  uint8_t col;
+  uint8_t byte;
+  uint32_t time_us;
+} predict_t;
+
 
 
 static terminal_char_t screen[ROW_MAX_HARD][COL_MAX_HARD];
 static bool screen_changed[ROW_MAX_HARD][COL_MAX_HARD];
+static uint16_t screen_checksum[ROW_MAX_HARD][COL_MAX_HARD + 1]; /* Prefix */
+static bool screen_checksum_stale[ROW_MAX_HARD];
+static bool screen_damaged = false;
+static uint32_t screen_damage_us;
 static bool tab_stop[COL_MAX_HARD];
 
 static int cursor_row;
@@ -31,19 +52,32 @@ static int cursor_col;
 static int margin_top;
 static int margin_bottom;
 static uint8_t cursor_print_attribute;
+static uint8_t cursor_cell_attribute; /* Under the cursor, while shown. */
+static bool cursor_shown;
+static uint16_t cursor_published; /* Row and column between chunks. */
 static bool cursor_outside_scroll;
 
 static uint8_t current_g0_set;
 static uint8_t current_g1_set;
 
+static uint8_t last_print_byte;
+
 static int saved_row;
 static int saved_col;
 static uint8_t saved_print_attribute;
 
 static escape_t escape;
+static bool escape_unhandled;
 static char param[PARAM_MAX][PARAM_LEN];
 static int param_index;
 static bool param_used;
+static char param_intermediate;
+
+static uint8_t frame[DIFFFRAME_SIZE];
+static int frame_len;
+static int frame_pos;
+static uint16_t frame_sum;
+static bool frame_escaped;
 
 static bool mode_cursor_key_app    = false;
 static bool mode_ansi              = true;
@@ -56,6 +90,15 @@ static bool mode_auto_repeat       = false;
 static bool mode_interlace         = false;
 static bool mode_keypad_app        = false;
 static bool mode_line_feed         = false;
+static bool mode_bracketed_paste   = false;
+
+/* Typed characters shown before the host has echoed them. The keyboard
+   side adds at the tail, the receive side takes from the head. */
+static predict_t predict[PREDICT_MAX];
+static uint8_t predict_head = 0;
+static uint8_t predict_tail = 0;
+static volatile bool predict_enabled = false;
+static volatile bool predict_trusted = false; /* Echo seen as typed. */
 
 
 
@@ -75,6 +118,7 @@ static inline void param_reset(void)
 {
   param_index = 0;
   param_used = false;
+  param_intermediate = '\0';
   for (int i = 0; i < PARAM_MAX; i++) {
     param[i][0] = '\0';
   }
@@ -87,7 +131,7 @@ static inline void param_append(char c)
     len++;
   }
   if (len >= (PARAM_LEN - 1)) {
-    error_log("Overflow on parameter length!\n");
+    trace(TRACE_PARAM_OVERFLOW, param_index, len);
     return;
   }
   param[param_index][len] = c;
@@ -130,12 +174,88 @@ static inline void tab_stop_default(void)
 
 
 
+static inline uint16_t checksum_char(terminal_char_t c)
+{
+  uint16_t sum = c.byte;
+
+  /* Attribute weights as used by the VT420 and xterm. */
+  if ((c.attribute >> TERMINAL_ATTRIBUTE_UNDERLINE) & 0x1) {
+    sum += 0x10;
+  }
+  if ((c.attribute >> TERMINAL_ATTRIBUTE_REVERSE) & 0x1) {
+    sum += 0x20;
+  }
+  if ((c.attribute >> TERMINAL_ATTRIBUTE_BLINK) & 0x1) {
+    sum += 0x40;
+  }
+  if ((c.attribute >> TERMINAL_ATTRIBUTE_BOLD) & 0x1) {
+    sum += 0x80;
+  }
+  return sum;
+}
+
+static uint16_t checksum_area(int top, int left, int bottom, int right)
+{
+  uint16_t sum = 0;
+
+  /* Prefix sums of a row are only made again after it changed, so that
+     writing to the screen costs nothing extra. */
+  for (int row = top; row <= bottom; row++) {
+    if (screen_checksum_stale[row]) {
+      for (int col = 0; col < COL_MAX_HARD; col++) {
+        screen_checksum[row][col + 1] =
+          screen_checksum[row][col] + checksum_char(screen[row][col]);
+      }
+      screen_checksum_stale[row] = false;
+    }
+    sum += screen_checksum[row][right + 1] - screen_checksum[row][left];
+  }
+  return sum;
+}
+
+
+
+static inline void screen_damage(void)
+{
+  if (! screen_damaged) {
+    screen_damage_us = timer_us();
+    screen_damaged = true;
+  }
+}
+
+
+
 static inline void screen_set(int row, int col, terminal_char_t c)
 {
   if (screen[row][col].byte != c.byte ||
       screen[row][col].attribute != c.attribute) {
     screen[row][col] = c;
     screen_changed[row][col] = true;
+    screen_checksum_stale[row] = true;
+    stats_count(STATS_CELLS_DIRTIED);
+    screen_damage();
+  }
+}
+
+
+
+static inline void screen_row_copy(int to, int from)
+{
+  int changed = 0;
+
+  /* A whole row at once, only the cells that differ marked as changed. */
+  for (int col = 0; col <= col_max(); col++) {
+    if (screen[to][col].byte != screen[from][col].byte ||
+        screen[to][col].attribute != screen[from][col].attribute) {
+      screen_changed[to][col] = true;
+      changed++;
+    }
+  }
+  if (changed > 0) {
+    memcpy(screen[to], screen[from], sizeof(screen[to]));
+    screen_checksum_stale[to] = true;
+    stats_count_add(STATS_CELLS_DIRTIED, changed);
+    screen_damage();
   }
 }
 
@@ -167,7 +287,7 @@ static inline void erase_in_char(uint8_t row, uint8_t col)
 
 
 
-static void erase_in_line(int p)
+static void SRAM_FUNC(erase_in_line)(int p)
 {
   int col;
 
@@ -193,7 +313,7 @@ static void erase_in_line(int p)
 
 
 
-static void erase_in_display(int p)
+static void SRAM_FUNC(erase_in_display)(int p)
 {
   int row, col;
 
@@ -227,25 +347,25 @@ static void erase_in_display(int p)
 
 
 
-static void scroll_up(void)
+static void SRAM_FUNC(scroll_up)(void)
 {
-  int row, col;
+  int row;
+  stats_count(STATS_SCROLLS);
+  trace(TRACE_SCROLL, 0, cursor_row);
   for (row = margin_top + 1; row < (margin_bottom + 1); row++) {
-    for (col = 0; col <= col_max(); col++) {
-      screen_set(row - 1, col, screen_get(row, col));
-    }
+    screen_row_copy(row - 1, row);
   }
   cursor_row = margin_bottom;
   erase_in_line(2);
 }
 
-static void scroll_down(void)
+static void SRAM_FUNC(scroll_down)(void)
 {
-  int row, col;
+  int row;
+  stats_count(STATS_SCROLLS);
+  trace(TRACE_SCROLL, 1, cursor_row);
   for (row = margin_bottom; row > margin_top; row--) {
-    for (col = 0; col <= col_max(); col++) {
-      screen_set(row, col, screen_get(row - 1, col));
-    }
+    screen_row_copy(row, row - 1);
   }
   cursor_row = margin_top;
   erase_in_line(2);
@@ -253,15 +373,87 @@ static void scroll_down(void)
 
 
 
+static void scroll_lines(int n)
+{
+  int height = margin_bottom - margin_top + 1;
+  int row, col;
+
+  if (n > height) {
+    n = height;
+  } else if (n < -height) {
+    n = -height;
+  }
+  stats_count_add(STATS_SCROLLS, (n < 0) ? -n : n);
+  trace(TRACE_SCROLL, (n < 0) ? 1 : 0, cursor_row);
+
+  /* Rows are moved by the whole count at once, and those left are
+     erased, so a large count costs no more than the region. */
+  if (n > 0) {
+    for (row = margin_top; row <= (margin_bottom - n); row++) {
+      screen_row_copy(row, row + n);
+    }
+    row = margin_bottom - n + 1;
+  } else {
+    for (row = margin_bottom; row >= (margin_top - n); row--) {
+      screen_row_copy(row, row + n);
+    }
+    row = margin_top;
+    n = -n;
+  }
+  for (int last = row + n; row < last; row++) {
+    for (col = 0; col <= col_max(); col++) {
+      erase_in_char(row, col);
+    }
+  }
+}
+
+
+
+static void reply_decimal(int value)
+{
+  if (value >= 10) {
+    reply_decimal(value / 10);
+  }
+  eia_send('0' + (value % 10));
+}
+
+static void reply_hex(uint16_t value)
+{
+  for (int shift = 12; shift >= 0; shift -= 4) {
+    eia_send("0123456789ABCDEF"[(value >> shift) & 0xF]);
+  }
+}
+
+
+
+static inline void scroll_check(void)
+{
+  if (cursor_outside_scroll) {
+    if (cursor_row >= margin_top && cursor_row <= margin_bottom) {
+      cursor_outside_scroll = false;
+    }
+  }
+  if (! cursor_outside_scroll) {
+    if (cursor_row > margin_bottom) {
+      scroll_up();
+    } else if (cursor_row < margin_top) {
+      scroll_down();
+    }
+  }
+}
+
+
+
 static inline void print_char(uint8_t byte)
 {
   terminal_char_t c;
 
-  /* Handle cursor wrapping. */
+  /* Handle cursor wrapping, scrolling on each wrap as for a line feed. */
   if (cursor_col > col_max()) {
     if (mode_wraparound) {
       cursor_col = 0;
       cursor_row++;
+      scroll_check();
       if (cursor_row > row_max()) {
         cursor_row = row_max();
       }
@@ -272,6 +464,7 @@ static inline void print_char(uint8_t byte)
 
   c.byte = byte;
   c.attribute = cursor_print_attribute;
+  last_print_byte = byte;
 
   screen_set(cursor_row, cursor_col, c);
   if (byte == ' ' && cursor_col == col_max()) {
@@ -310,8 +503,13 @@ static inline void cursor_activate(void)
   if (cursor_row > row_max()) {
     return;
   }
+  if (cursor_shown) {
+    return; /* Would save the cursor as the attribute under it. */
+  }
 
   c = screen_get(cursor_row, cursor_col);
+  cursor_cell_attribute = c.attribute;
+  cursor_shown = true;
   c.attribute |= (0x1 << TERMINAL_ATTRIBUTE_REVERSE);
   c.attribute |= (0x1 << TERMINAL_ATTRIBUTE_BLINK);
   screen_set(cursor_row, cursor_col, c);
@@ -323,22 +521,20 @@ static inline void cursor_deactivate(void)
 {
   terminal_char_t c;
 
-  if (cursor_col > col_max()) {
-    return;
-  }
-  if (cursor_row > row_max()) {
+  if (! cursor_shown) {
     return;
   }
+  cursor_shown = false;
 
+  /* Restored, so reverse or blinking text under the cursor is kept. */
   c = screen_get(cursor_row, cursor_col);
-  c.attribute &= ~(0x1 << TERMINAL_ATTRIBUTE_REVERSE);
-  c.attribute &= ~(0x1 << TERMINAL_ATTRIBUTE_BLINK);
+  c.attribute = cursor_cell_attribute;
   screen_set(cursor_row, cursor_col, c);
 }
 
 
 
-void terminal_init(void)
+static void reset_initial_state(void)
 {
   cursor_row = 0;
   cursor_col = 0;
@@ -348,16 +544,33 @@ void terminal_init(void)
   current_g0_set = 0;
   current_g1_set = 0;
 
+  last_print_byte = 0;
+
   saved_row = 0;
   saved_col = 0;
   saved_print_attribute = 0;
 
   escape = ESCAPE_NONE;
 
+  mode_cursor_key_app    = false;
+  mode_ansi              = true;
+  mode_column_132        = false;
+  mode_scrolling_smooth  = false;
+  mode_screen_reverse    = false;
+  mode_origin_relative   = false;
+  mode_wraparound        = false;
+  mode_auto_repeat       = false;
+  mode_interlace         = false;
+  mode_keypad_app        = false;
+  mode_line_feed         = false;
+  mode_bracketed_paste   = false;
+
   margin_top = 0;
   margin_bottom = row_max();
 
   for (int row = 0; row < ROW_MAX_HARD; row++) {
+    screen_checksum[row][0] = 0;
+    screen_checksum_stale[row] = true;
     for (int col = 0; col < COL_MAX_HARD; col++) {
       screen[row][col].byte = ' ';
       screen[row][col].attribute = 0;
@@ -365,14 +578,184 @@ void terminal_init(void)
     }
   }
 
+  tab_stop_clear(-1);
   tab_stop_default();
 
+  cursor_shown = false; /* Gone with the rest of the screen. */
+}
+
+
+
+static inline void cursor_publish(void)
+{
+  /* For the keyboard side, which must not see a chunk half applied. */
+  __atomic_store_n(&cursor_published, (cursor_row << 8) | cursor_col,
+    __ATOMIC_RELEASE);
+}
+
+
+
+void terminal_init(void)
+{
+  reset_initial_state();
   cursor_activate();
+  cursor_publish();
 }
 
 
 
-void terminal_handle_escape_csi(uint8_t byte)
+static void mode_set(bool set)
+{
+  bool private = (param[0][0] == '?');
+  int mode;
+
+  /* Modes are compared whole, so "?25" is not taken for "?2". The
+     private marker is only in front of the first parameter. */
+  for (int i = 0; i <= param_index; i++) {
+    mode = atoi(&param[i][(i == 0 && private) ? 1 : 0]);
+    if (! private) {
+      if (mode == 20) {
+        mode_line_feed = set;
+      }
+      continue;
+    }
+
+    switch (mode) {
+    case 1:
+      mode_cursor_key_app = set;
+      break;
+
+    case 2:
+      if (! set) {
+        mode_ansi = false;
+      }
+      break;
+
+    case 3:
+      mode_column_132 = set;
+      erase_in_display(2);
+      cursor_row = margin_top;
+      cursor_col = 0;
+      break;
+
+    case 4:
+      mode_scrolling_smooth = set;
+      break;
+
+    case 5:
+      mode_screen_reverse = set;
+      break;
+
+    case 6:
+      mode_origin_relative = set;
+      cursor_row = margin_top;
+      cursor_col = 0;
+      break;
+
+    case 7:
+      mode_wraparound = set;
+      break;
+
+    case 8:
+      mode_auto_repeat = set;
+      break;
+
+    case 9:
+      mode_interlace = set;
+      break;
+
+    case 2004: /* Bracketed paste, from xterm. */
+      mode_bracketed_paste = set;
+      break;
+
+    default:
+      break;
+    }
+  }
+}
+
+
+
+static void frame_reply(uint8_t value)
+{
+  static const char reply[] = "\x1b[?910;";
+
+  for (int i = 0; reply[i] != '\0'; i++) {
+    eia_send(reply[i]);
+  }
+  eia_send('0' + value);
+  eia_send('n');
+}
+
+
+
+static bool frame_apply(void)
+{
+  int i = 0, row = 0, col = 0, count;
+  uint8_t op;
+  terminal_char_t c;
+
+  /* Checked as it goes, a bad operation ends the frame there. */
+  c.attribute = 0;
+  while (i < frame_len) {
+    op = frame[i++];
+    switch (op) {
+    case DIFFFRAME_OP_GOTO:
+    case DIFFFRAME_OP_CURSOR:
+      if ((i + 2) > frame_len || frame[i] > row_max() ||
+          frame[i + 1] > col_max()) {
+        return false;
+      }
+      if (op == DIFFFRAME_OP_GOTO) {
+        row = frame[i];
+        col = frame[i + 1];
+      } else {
+        cursor_row = frame[i];
+        cursor_col = frame[i + 1];
+      }
+      i += 2;
+      break;
+
+    case DIFFFRAME_OP_ATTRIBUTE:
+      if ((i + 1) > frame_len) {
+        return false;
+      }
+      c.attribute = frame[i++];
+      break;
+
+    case DIFFFRAME_OP_REPEAT:
+    case DIFFFRAME_OP_CELLS:
+      if ((i + 1) > frame_len) {
+        return false;
+      }
+      count = frame[i++];
+      if ((i + ((op == DIFFFRAME_OP_REPEAT) ? 1 : count)) > frame_len) {
+        return false;
+      }
+      for (int n = 0; n < count; n++) {
+        if (row > row_max()) {
+          return false;
+        }
+        c.byte = (op == DIFFFRAME_OP_REPEAT) ? frame[i] : frame[i + n];
+        screen_set(row, col, c);
+        if (++col > col_max()) {
+          col = 0;
+          row++;
+        }
+      }
+      i += (op == DIFFFRAME_OP_REPEAT) ? 1 : count;
+      break;
+
+    default:
+      return false;
+    }
+  }
+  return true;
+}
+
+
+
+void SRAM_FUNC(terminal_handle_escape_csi)(uint8_t byte)
 {
   int param_int, i;
 
@@ -421,6 +804,153 @@ void terminal_handle_escape_csi(uint8_t byte)
     escape = ESCAPE_NONE;
     break;
 
+  case 'E': /* CNL - Cursor Next Line */
+    param_int = (param_used) ? atoi(param[0]) : 1;
+    param_int = (param_int == 0) ? 1 : param_int; /* Convert zero to one. */
+    if (param_int > (margin_bottom - cursor_row)) {
+      cursor_row = margin_bottom;
+    } else {
+      cursor_row += param_int;
+    }
+    cursor_col = 0;
+    escape = ESCAPE_NONE;
+    break;
+
+  case 'F': /* CPL - Cursor Preceding Line */
+    param_int = (param_used) ? atoi(param[0]) : 1;
+    param_int = (param_int == 0) ? 1 : param_int; /* Convert zero to one. */
+    if (param_int > (cursor_row - margin_top)) {
+      cursor_row = margin_top;
+    } else {
+      cursor_row -= param_int;
+    }
+    cursor_col = 0;
+    escape = ESCAPE_NONE;
+    break;
+
+  case '`': /* HPA - Horizontal Position Absolute */
+  case 'G': /* CHA - Cursor Horizontal Absolute */
+    cursor_col = ((param_used) ? atoi(param[0]) : 1) - 1;
+    if (cursor_col > col_max()) {
+      cursor_col = col_max();
+    } else if (cursor_col < 0) {
+      cursor_col = 0;
+    }
+    escape = ESCAPE_NONE;
+    break;
+
+  case 'd': /* VPA - Vertical Position Absolute */
+    cursor_row = ((param_used) ? atoi(param[0]) : 1) - 1;
+    cursor_row = (cursor_row < 0) ? 0 : cursor_row; /* Negative to zero. */
+    if (mode_origin_relative) {
+      cursor_row += margin_top; /* Compensate for different origin. */
+      if (cursor_row > margin_bottom) {
+        cursor_row = margin_bottom;
+      }
+    }
+    if (cursor_row > row_max()) {
+      cursor_row = row_max();
+    }
+    escape = ESCAPE_NONE;
+    break;
+
+  case 'X': /* ECH - Erase Character */
+    param_int = (param_used) ? atoi(param[0]) : 1;
+    param_int = (param_int == 0) ? 1 : param_int; /* Convert zero to one. */
+    if (param_int > (col_max() - cursor_col + 1)) {
+      param_int = col_max() - cursor_col + 1;
+    }
+    for (i = cursor_col; i < (cursor_col + param_int); i++) {
+      erase_in_char(cursor_row, i);
+    }
+    escape = ESCAPE_NONE;
+    break;
+
+  case 'b': /* REP - Repeat Preceding Character */
+    param_int = (param_used) ? atoi(param[0]) : 1;
+    param_int = (param_int == 0) ? 1 : param_int; /* Convert zero to one. */
+    if (param_int > ((row_max() + 1) * (col_max() + 1))) {
+      param_int = (row_max() + 1) * (col_max() + 1);
+    }
+    if (last_print_byte != 0) {
+      for (i = 0; i < param_int; i++) {
+        print_char(last_print_byte);
+      }
+    }
+    escape = ESCAPE_NONE;
+    break;
+
+  case 'S': /* SU - Scroll Up */
+    param_int = (param_used) ? atoi(param[0]) : 1;
+    param_int = (param_int == 0) ? 1 : param_int; /* Convert zero to one. */
+    scroll_lines(param_int);
+    escape = ESCAPE_NONE;
+    break;
+
+  case 'T': /* SD - Scroll Down */
+    param_int = (param_used) ? atoi(param[0]) : 1;
+    param_int = (param_int == 0) ? 1 : param_int; /* Convert zero to one. */
+    scroll_lines(-param_int);
+    escape = ESCAPE_NONE;
+    break;
+
+  case 'y':
+    if (param_intermediate == '*') { /* DECRQCRA - Request Checksum */
+      int top, left, bottom, right;
+
+      top =    ((param_index > 1) ? atoi(param[2]) : 0) - 1;
+      left =   ((param_index > 2) ? atoi(param[3]) : 0) - 1;
+      bottom = ((param_index > 3) ? atoi(param[4]) : 0) - 1;
+      right =  ((param_index > 4) ? atoi(param[5]) : 0) - 1;
+      top =    (top < 0)    ? 0         : top; /* Zero means default. */
+      left =   (left < 0)   ? 0         : left;
+      bottom = (bottom < 0) ? row_max() : bottom;
+      right =  (right < 0)  ? col_max() : right;
+
+      if (mode_origin_relative) {
+        top += margin_top; /* Compensate for different origin. */
+        bottom += margin_top;
+        if (bottom > margin_bottom) {
+          bottom = margin_bottom;
+        }
+      }
+      if (bottom > row_max()) {
+        bottom = row_max();
+      }
+      if (right > col_max()) {
+        right = col_max();
+      }
+
+      eia_send(0x1B);
+      eia_send('P');
+      reply_decimal((param_used) ? atoi(param[0]) : 0);
+      eia_send('!');
+      eia_send('~');
+      if (top <= bottom && left <= right) {
+        /* Reported as the negative sum, like the VT420. */
+        reply_hex(-checksum_area(top, left, bottom, right));
+      } else {
+        reply_hex(0);
+      }
+      eia_send(0x1B);
+      eia_send('\\');
+    } else {
+      escape_unhandled = true;
+    }
+    escape = ESCAPE_NONE;
+    break;
+
+  case 'n': /* DSR - Device Status Report */
+    if (param[0][0] == '?' && atoi(&param[0][1]) == DIFFFRAME_CODE) {
+      frame_reply(DIFFFRAME_VERSION);
+    } else if (param[0][0] == '?') {
+      diag_request(atoi(&param[0][1])); /* Private diagnostic reports. */
+    } else {
+      escape_unhandled = true;
+    }
+    escape = ESCAPE_NONE;
+    break;
+
   case 'c': /* DA - Device Attributes */
     eia_send(0x1B);
     eia_send('[');
@@ -432,6 +962,23 @@ void terminal_handle_escape_csi(uint8_t byte)
     escape = ESCAPE_NONE;
     break;
 
+  case 'z': /* Screen difference frame, see diffframe.h. */
+    frame_len = 0;
+    if (param[0][0] == '?' && atoi(&param[0][1]) == DIFFFRAME_CODE &&
+        param_index == 2) {
+      frame_len = atoi(param[1]);
+      frame_sum = atoi(param[2]);
+    }
+    if (frame_len > 0 && frame_len <= DIFFFRAME_SIZE) {
+      frame_pos = 0;
+      frame_escaped = false;
+      escape = ESCAPE_FRAME;
+    } else {
+      escape_unhandled = true;
+      escape = ESCAPE_NONE;
+    }
+    break;
+
   case 'g': /* TBC - Tabulation Clear */
     param_int = (param_used) ? atoi(param[0]) : 0;
     if (param_int == 0) {
@@ -443,81 +990,12 @@ void terminal_handle_escape_csi(uint8_t byte)
     break;
 
   case 'h': /* SM - Set Mode */
-    for (i = 0; i <= param_index; i++) {
-      if ((param[i][0]        == '?') && (param[i][1] == '1')) {
-        mode_cursor_key_app = true;
-
-      } else if ((param[i][0] == '?') && (param[i][1] == '3')) {
-        mode_column_132 = true;
-        erase_in_display(2);
-        cursor_row = margin_top;
-        cursor_col = 0;
-
-      } else if ((param[i][0] == '?') && (param[i][1] == '4')) {
-        mode_scrolling_smooth = true;
-
-      } else if ((param[i][0] == '?') && (param[i][1] == '5')) {
-        mode_screen_reverse = true;
-
-      } else if ((param[i][0] == '?') && (param[i][1] == '6')) {
-        mode_origin_relative = true;
-        cursor_row = margin_top;
-        cursor_col = 0;
-
-      } else if ((param[i][0] == '?') && (param[i][1] == '7')) {
-        mode_wraparound = true;
-
-      } else if ((param[i][0] == '?') && (param[i][1] == '8')) {
-        mode_auto_repeat = true;
-
-      } else if ((param[i][0] == '?') && (param[i][1] == '9')) {
-        mode_interlace = true;
-
-      } else if ((param[i][0] == '2') && (param[i][1] == '0')) {
-        mode_line_feed = true;
-      }
-    }
+    mode_set(true);
     escape = ESCAPE_NONE;
     break;
 
   case 'l': /* RM - Reset Mode */
-    for (i = 0; i <= param_index; i++) {
-      if ((param[i][0]        == '?') && (param[i][1] == '1')) {
-        mode_cursor_key_app = false;
-
-      } else if ((param[i][0] == '?') && (param[i][1] == '2')) {
-        mode_ansi = false;
-
-      } else if ((param[i][0] == '?') && (param[i][1] == '3')) {
-        mode_column_132 = false;
-        erase_in_display(2);
-        cursor_row = margin_top;
-        cursor_col = 0;
-
-      } else if ((param[i][0] == '?') && (param[i][1] == '4')) {
-        mode_scrolling_smooth = false;
-
-      } else if ((param[i][0] == '?') && (param[i][1] == '5')) {
-        mode_screen_reverse = false;
-
-      } else if ((param[i][0] == '?') && (param[i][1] == '6')) {
-        mode_origin_relative = false;
-        cursor_row = margin_top;
-        cursor_col = 0;
-
-      } else if ((param[i][0] == '?') && (param[i][1] == '7')) {
-        mode_wraparound = false;
-
-      } else if ((param[i][0] == '?') && (param[i][1] == '8')) {
-        mode_auto_repeat = false;
-
-      } else if ((param[i][0] == '?') && (param[i][1] == '9')) {
-        mode_interlace = false;
-
-      } else if ((param[i][0] == '2') && (param[i][1] == '0')) {
-        mode_line_feed = false;
-      }
-    }
+    mode_set(false);
     escape = ESCAPE_NONE;
     break;
 
@@ -600,11 +1078,15 @@ void terminal_handle_escape_csi(uint8_t byte)
   case ';':
     param_index++;
     if (param_index >= PARAM_MAX) {
-      error_log("Overflow on parameter!\n");
+      trace(TRACE_PARAM_OVERFLOW, param_index, 0);
       param_index--;
     }
     break;
 
+  case '*': /* Intermediate */
+    param_intermediate = (char)byte;
+    break;
+
   /* Parameter */
   case '0':
   case '1':
@@ -638,7 +1120,7 @@ void terminal_handle_escape_csi(uint8_t byte)
     break;
 
   default:
-    error_log("Unhandled CSI escape code: 0x%02x\n", byte);
+    escape_unhandled = true;
     escape = ESCAPE_NONE;
     break;
   }
@@ -655,7 +1137,7 @@ void terminal_handle_escape_hash(uint8_t byte)
     break;
 
   default:
-    error_log("Unhandled hash escape code: 0x%02x\n", byte);
+    escape_unhandled = true;
     escape = ESCAPE_NONE;
     break;
   }
@@ -663,8 +1145,12 @@ void terminal_handle_escape_hash(uint8_t byte)
 
 
 
-void terminal_handle_escape(uint8_t byte)
+void SRAM_FUNC(terminal_handle_escape)(uint8_t byte)
 {
+  escape_t type = escape;
+
+  escape_unhandled = false;
+
   if (escape == ESCAPE_CSI) {
     terminal_handle_escape_csi(byte);
 
@@ -679,6 +1165,24 @@ void terminal_handle_escape(uint8_t byte)
     current_g1_set = byte;
     escape = ESCAPE_NONE;
 
+  } else if (escape == ESCAPE_FRAME) {
+    if (byte == DIFFFRAME_ESCAPE) {
+      frame_escaped = true;
+    } else {
+      if (frame_escaped) {
+        byte ^= DIFFFRAME_ESCAPE_XOR;
+        frame_escaped = false;
+      }
+      frame[frame_pos++] = byte;
+      if (frame_pos >= frame_len) {
+        if (diffframe_sum(frame, frame_len) != frame_sum || ! frame_apply()) {
+          escape_unhandled = true;
+          frame_reply(0); /* The host sends everything again. */
+        }
+        escape = ESCAPE_NONE;
+      }
+    }
+
   } else {
     switch (byte) {
     case '[':
@@ -750,28 +1254,144 @@ void terminal_handle_escape(uint8_t byte)
       break;
 
     case 'c': /* RIS - Reset To Initial State */
-      terminal_init();
+      reset_initial_state(); /* Cursor shown again after the chunk. */
       escape = ESCAPE_NONE;
       break;
 
     default:
-      error_log("Unhandled escape code: 0x%02x\n", byte);
+      escape_unhandled = true;
       escape = ESCAPE_NONE;
       break;
     }
   }
+
+  if (escape == ESCAPE_NONE) {
+    if (type == ESCAPE_CSI) {
+      stats_sequence(STATS_SEQUENCE_CSI, byte, ! escape_unhandled);
+    } else if (type == ESCAPE_FRAME) {
+      stats_sequence(STATS_SEQUENCE_CSI, 'z', ! escape_unhandled);
+    } else if (type == ESCAPE_HASH) {
+      stats_sequence(STATS_SEQUENCE_HASH, byte, ! escape_unhandled);
+    } else if (type == ESCAPE_G0_SET) {
+      stats_sequence(STATS_SEQUENCE_ESC, '(', true);
+    } else if (type == ESCAPE_G1_SET) {
+      stats_sequence(STATS_SEQUENCE_ESC, ')', true);
+    } else {
+      stats_sequence(STATS_SEQUENCE_ESC, byte, ! escape_unhandled);
+    }
+    trace((escape_unhandled) ? TRACE_UNHANDLED : TRACE_SEQUENCE, type, byte);
+  }
 }
 
 
 
-void terminal_handle_byte(uint8_t byte)
+static inline int predict_count(uint8_t head, uint8_t tail)
 {
-  cursor_deactivate();
+  return (tail + PREDICT_MAX - head) % PREDICT_MAX;
+}
+
+
+
+static void predict_rollback(void)
+{
+  uint8_t head = predict_head;
+  uint8_t tail = __atomic_load_n(&predict_tail, __ATOMIC_ACQUIRE);
+  int row = predict[head].row;
+  int col = predict[head].col;
+  int count = predict_count(head, tail);
+
+  /* Taken off first, then redrawn as the screen really is, including the
+     cell the cursor was shown on after them. */
+  __atomic_store_n(&predict_head, tail, __ATOMIC_RELEASE);
+  for (int i = col; i <= (col + count) && i <= col_max(); i++) {
+    screen_changed[row][i] = true;
+  }
+  stats_count_add(STATS_PREDICT_ROLLED_BACK, count);
+}
+
+
+
+static inline void predict_check(uint8_t byte)
+{
+  uint8_t head = predict_head;
+  predict_t p;
+
+  if (head == __atomic_load_n(&predict_tail, __ATOMIC_ACQUIRE)) {
+    return;
+  }
+
+  /* The oldest is confirmed by the same character printed in its place,
+     anything else drops them all. */
+  p = predict[head];
+  if (escape == ESCAPE_NONE && cursor_row == p.row && cursor_col == p.col &&
+      byte >= 0x20 && byte != 0x7F) {
+    predict_trusted = (byte == p.byte);
+    if (byte == p.byte) {
+      __atomic_store_n(&predict_head, (head + 1) % PREDICT_MAX,
+        __ATOMIC_RELEASE);
+      screen_changed[p.row][p.col] = true;
+      if (p.col < col_max()) {
+        screen_changed[p.row][p.col + 1] = true;
+      }
+      stats_count(STATS_PREDICT_CONFIRMED);
+      return;
+    }
+  }
+  predict_rollback();
+}
+
+
+
+static inline void predict_overlay(int row, int col, terminal_char_t *c)
+{
+  uint8_t head = __atomic_load_n(&predict_head, __ATOMIC_ACQUIRE);
+  uint8_t tail = __atomic_load_n(&predict_tail, __ATOMIC_ACQUIRE);
+  int first, count;
+
+  if (head == tail || ! predict_enabled || ! predict_trusted) {
+    return;
+  }
+  if (row != predict[head].row) {
+    return;
+  }
+  first = predict[head].col;
+  count = predict_count(head, tail);
+  if (col < first || col > (first + count)) {
+    return;
+  }
+  if ((timer_us() - predict[head].time_us) > PREDICT_TIMEOUT_US) {
+    predict_trusted = false; /* No echo, such as at a password prompt. */
+    return;
+  }
+
+  /* Underlined, with the cursor shown after the last of them. */
+  if (col < (first + count)) {
+    c->byte = predict[(head + col - first) % PREDICT_MAX].byte;
+    c->attribute = (0x1 << TERMINAL_ATTRIBUTE_UNDERLINE);
+  } else {
+    c->attribute |= (0x1 << TERMINAL_ATTRIBUTE_REVERSE);
+    c->attribute |= (0x1 << TERMINAL_ATTRIBUTE_BLINK);
+  }
+}
+
+
+
+static inline void handle_byte(uint8_t byte)
+{
+  stats_count(STATS_RX_BYTES);
+  predict_check(byte);
 
   if (escape != ESCAPE_NONE) {
+    stats_count(STATS_ESCAPE);
     terminal_handle_escape(byte);
 
   } else {
+    if (byte < 0x20 || byte == 0x7F) {
+      stats_count(STATS_CONTROL);
+    } else {
+      stats_count(STATS_PRINTABLE);
+    }
+
     switch (byte) {
     case 0x1B: /* ESC */
       escape = ESCAPE_START;
@@ -829,52 +1449,126 @@ void terminal_handle_byte(uint8_t byte)
   }
 
   /* Handle scrolling. */
-  if (cursor_outside_scroll) {
-    if (cursor_row >= margin_top && cursor_row <= margin_bottom) {
-      cursor_outside_scroll = false;
-    }
-  }
-  if (! cursor_outside_scroll) {
-    if (cursor_row > margin_bottom) {
-      scroll_up();
-    } else if (cursor_row < margin_top) {
-      scroll_down();
-    }
-  }
+  scroll_check();
+}
+
 
+
+void SRAM_FUNC(terminal_handle_byte)(uint8_t byte)
+{
+  cursor_deactivate();
+  handle_byte(byte);
   cursor_activate();
+  cursor_publish();
 }
 
 
 
-bool terminal_char_changed(uint8_t row, uint8_t col)
+void SRAM_FUNC(terminal_handle_buffer)(const uint8_t *data, size_t len)
+{
+  /* The cursor is only moved off and back on once for the whole chunk. */
+  cursor_deactivate();
+  for (size_t i = 0; i < len; i++) {
+    handle_byte(data[i]);
+  }
+  cursor_activate();
+  cursor_publish();
+}
+
+
+
+bool SRAM_FUNC(terminal_char_changed)(uint8_t row, uint8_t col)
 {
   if ((screen[row][col].attribute >> TERMINAL_ATTRIBUTE_BLINK) & 0x1) {
     return true;
   }
+  if (predict_head != predict_tail && row == predict[predict_head].row) {
+    return true; /* Redrawn while predictions on it come and go. */
+  }
   return screen_changed[row][col];
 }
 
 
 
-terminal_char_t terminal_char_get(uint8_t row, uint8_t col)
+terminal_char_t terminal_char_peek(uint8_t row, uint8_t col)
 {
   terminal_char_t c;
   c.byte = '.';
   c.attribute = 0;
 
+  /* Like terminal_char_get(), but leaves the change for the renderer. */
   if (row > row_max()) {
     return c;
   } else if (col > col_max()) {
     return c;
   } else {
-    screen_changed[row][col] = false;
     return screen_get(row, col);
   }
 }
 
 
 
+terminal_char_t terminal_char_plain(uint8_t row, uint8_t col)
+{
+  terminal_char_t c = terminal_char_peek(row, col);
+
+  /* As it is under the cursor, for a copy of the screen elsewhere. */
+  if (cursor_shown && row == cursor_row && col == cursor_col) {
+    c.attribute = cursor_cell_attribute;
+  }
+  return c;
+}
+
+
+
+void terminal_cursor_get(uint8_t *row, uint8_t *col)
+{
+  *row = cursor_row;
+  *col = cursor_col;
+}
+
+
+
+uint8_t terminal_columns(void)
+{
+  return col_max() + 1;
+}
+
+
+
+bool terminal_damage_take(uint32_t *since_us)
+{
+  /* Time of the first change since the last call, for render lag. */
+  if (! screen_damaged) {
+    return false;
+  }
+  *since_us = screen_damage_us;
+  screen_damaged = false;
+  return true;
+}
+
+
+
+terminal_char_t SRAM_FUNC(terminal_char_get)(uint8_t row, uint8_t col)
+{
+  terminal_char_t c;
+  c.byte = '.';
+  c.attribute = 0;
+
+  if (row > row_max()) {
+    return c;
+  } else if (col > col_max()) {
+    return c;
+  } else {
+    screen_changed[row][col] = false;
+    c = screen_get(row, col);
+    predict_overlay(row, col, &c);
+    return c;
+  }
+}
+
+
+
 uint8_t terminal_cursor_key_code(void)
 {
   if (mode_ansi) {
@@ -901,3 +1595,54 @@ bool terminal_send_crlf(void)
 
 
 
+bool terminal_bracketed_paste(void)
+{
+  return mode_bracketed_paste;
+}
+
+
+
+void terminal_predict(uint8_t byte)
+{
+  uint8_t head = __atomic_load_n(&predict_head, __ATOMIC_ACQUIRE);
+  uint8_t tail = predict_tail;
+  uint16_t cursor = __atomic_load_n(&cursor_published, __ATOMIC_ACQUIRE);
+  uint8_t last;
+  predict_t p;
+
+  /* Only printable characters, on the cursor line. */
+  if (! predict_enabled || byte < 0x20 || byte == 0x7F ||
+      (byte >= 0x80 && byte < 0xA0)) {
+    return;
+  }
+  if (((tail + 1) % PREDICT_MAX) == head) {
+    return;
+  }
+  if (head == tail) {
+    p.row = cursor >> 8;
+    p.col = cursor & 0xFF;
+  } else {
+    last = (tail + PREDICT_MAX - 1) % PREDICT_MAX;
+    p.row = predict[last].row;
+    p.col = predict[last].col + 1;
+  }
+  if (p.row > row_max() || p.col > col_max()) {
+    return;
+  }
+  p.byte = byte;
+  p.time_us = timer_us();
+
+  predict[tail] = p;
+  __atomic_store_n(&predict_tail, (tail + 1) % PREDICT_MAX, __ATOMIC_RELEASE);
+}
+
+
+
+void terminal_predict_toggle(void)
+{
+  predict_enabled = ! predict_enabled;
+  predict_trusted = false;
+}
+
+
+
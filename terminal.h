@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #define TERMINAL_ATTRIBUTE_BOLD      1
 #define TERMINAL_ATTRIBUTE_UNDERLINE 2
@@ -16,9 +17,18 @@ typedef struct terminal_char_s {
 
 void terminal_init(void);
 void terminal_handle_byte(uint8_t byte);
+void terminal_handle_buffer(const uint8_t *data, size_t len);
 terminal_char_t terminal_char_get(uint8_t row, uint8_t col);
+terminal_char_t terminal_char_peek(uint8_t row, uint8_t col);
+terminal_char_t terminal_char_plain(uint8_t row, uint8_t col);
 bool terminal_char_changed(uint8_t row, uint8_t col);
+void terminal_cursor_get(uint8_t *row, uint8_t *col);
+uint8_t terminal_columns(void);
+bool terminal_damage_take(uint32_t *since_us);
 uint8_t terminal_cursor_key_code(void);
 bool terminal_send_crlf(void);
+bool terminal_bracketed_paste(void);
+void terminal_predict(uint8_t byte);
+void terminal_predict_toggle(void);
 
 #endif /* _TERMINAL_H */
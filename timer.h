@@ -0,0 +1,8 @@
+#ifndef _TIMER_H
+#define _TIMER_H
+
+#include <stdint.h>
+
+uint32_t timer_us(void);
+
+#endif /* _TIMER_H */
@@ -0,0 +1,15 @@
+#include <stdint.h>
+#include <time.h>
+#include "timer.h"
+
+
+
+uint32_t timer_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+
+
@@ -0,0 +1,13 @@
+#include <stdint.h>
+#include "pico/stdlib.h"
+#include "timer.h"
+
+
+
+uint32_t timer_us(void)
+{
+  return time_us_32();
+}
+
+
+
@@ -0,0 +1,61 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "trace.h"
+#include "diag.h"
+
+trace_entry_t trace_ring[TRACE_SIZE];
+volatile uint32_t trace_head = 0;
+volatile bool trace_enabled = false; /* Each event costs a timestamp. */
+volatile bool trace_paused = false;
+volatile bool trace_dump_requested = false;
+
+static const char *trace_event_name[TRACE_EVENT_MAX] = {
+  "sequence",
+  "unhandled",
+  "param_overflow",
+  "scroll",
+  "render_start",
+  "render_end",
+  "ps2_isr",
+  "ps2_parity",
+  "rx_burst",
+  "uart_overrun",
+};
+
+
+
+void trace_request(void)
+{
+  /* Called from key handlers, the dump itself is done by the main loop. */
+  trace_dump_requested = true;
+}
+
+
+
+void trace_report(diag_put_t put)
+{
+  uint32_t head, count, start;
+  trace_entry_t *entry;
+
+  /* Formatting is slow, so stop recording instead of racing the writers. */
+  trace_paused = true;
+  head = trace_head;
+  count = (head < TRACE_SIZE) ? head : TRACE_SIZE;
+  start = trace_ring[(head - count) & (TRACE_SIZE - 1)].time;
+
+  /* Oldest first, times relative to the oldest entry in microseconds. */
+  for (uint32_t i = head - count; i != head; i++) {
+    entry = &trace_ring[i & (TRACE_SIZE - 1)];
+    if (entry->event >= TRACE_EVENT_MAX) {
+      continue;
+    }
+    diag_printf(put, "%10lu %-14s %3u %5u\n",
+      (unsigned long)(entry->time - start), trace_event_name[entry->event],
+      entry->a, entry->b);
+  }
+
+  trace_paused = false;
+}
+
+
+
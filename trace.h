@@ -0,0 +1,58 @@
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "diag.h"
+#include "timer.h"
+
+#define DIAG_TRACE 901
+
+#define TRACE_SIZE 512 /* Must be a power of two. */
+
+typedef enum {
+  TRACE_SEQUENCE,
+  TRACE_UNHANDLED,
+  TRACE_PARAM_OVERFLOW,
+  TRACE_SCROLL,
+  TRACE_RENDER_START,
+  TRACE_RENDER_END,
+  TRACE_PS2_ISR,
+  TRACE_PS2_PARITY,
+  TRACE_RX_BURST,
+  TRACE_UART_OVERRUN,
+  TRACE_EVENT_MAX,
+} trace_event_t;
+
+typedef struct trace_entry_s {
+  uint32_t time;
+  uint8_t event;
+  uint8_t a;
+  uint16_t b;
+} trace_entry_t;
+
+extern trace_entry_t trace_ring[TRACE_SIZE];
+extern volatile uint32_t trace_head;
+extern volatile bool trace_enabled;
+extern volatile bool trace_paused;
+extern volatile bool trace_dump_requested;
+
+static inline void trace(trace_event_t event, uint8_t a, uint16_t b)
+{
+  trace_entry_t *entry;
+
+  /* Both cores may write, a lost or torn entry is acceptable here. */
+  if (! trace_enabled || trace_paused) {
+    return;
+  }
+  entry = &trace_ring[trace_head++ & (TRACE_SIZE - 1)];
+  entry->time = timer_us();
+  entry->event = event;
+  entry->a = a;
+  entry->b = b;
+}
+
+void trace_request(void);
+void trace_report(diag_put_t put);
+
+#endif /* _TRACE_H */
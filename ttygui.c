@@ -0,0 +1,357 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <termios.h>
+#include "terminal.h"
+#include "eia.h"
+#include "stats.h"
+#include "trace.h"
+#include "profile.h"
+#include "latency.h"
+#include "timer.h"
+
+/* Mirrors the emulated screen into the terminal on stdin and stdout,
+   sending only the cells that differ from what is already shown there. */
+
+#define TTYGUI_ROWS 24
+#define TTYGUI_COLS_MAX 132
+#define TTYGUI_FRAME_US 33000 /* 30 Hz is plenty over SSH. */
+#define TTYGUI_OUT_SIZE 65536
+#define TTYGUI_IN_SIZE 64
+#define TTYGUI_GAP_MAX 3 /* Unchanged cells rewritten instead of a move. */
+#define TTYGUI_QUIT 0x1D /* Ctrl-] */
+
+typedef enum {
+  TTYGUI_KEY_NONE,
+  TTYGUI_KEY_ESCAPE,
+  TTYGUI_KEY_CURSOR,
+} ttygui_key_t;
+
+
+
+static terminal_char_t ttygui_shadow[TTYGUI_ROWS][TTYGUI_COLS_MAX];
+static int ttygui_cols = 0;
+static int ttygui_row = -1; /* Host cursor, -1 when not known. */
+static int ttygui_col = -1;
+static uint8_t ttygui_attribute = 0;
+static char ttygui_out[TTYGUI_OUT_SIZE];
+static size_t ttygui_out_len = 0;
+static struct termios ttygui_tio_saved;
+static bool ttygui_tio_valid = false;
+static ttygui_key_t ttygui_key = TTYGUI_KEY_NONE;
+static uint8_t ttygui_key_held;
+static uint32_t ttygui_time = 0;
+
+
+
+static void ttygui_flush(void)
+{
+  size_t done = 0;
+  ssize_t result;
+
+  /* One write per pass, retried if the host terminal is slow. */
+  while (done < ttygui_out_len) {
+    result = write(STDOUT_FILENO, &ttygui_out[done], ttygui_out_len - done);
+    if (result == -1 && errno != EINTR && errno != EAGAIN) {
+      break;
+    }
+    if (result > 0) {
+      done += result;
+    }
+  }
+  ttygui_out_len = 0;
+}
+
+
+
+static void ttygui_printf(const char *format, ...)
+{
+  va_list args;
+  int len;
+
+  if ((TTYGUI_OUT_SIZE - ttygui_out_len) < 32) {
+    ttygui_flush();
+  }
+  va_start(args, format);
+  len = vsnprintf(&ttygui_out[ttygui_out_len],
+    TTYGUI_OUT_SIZE - ttygui_out_len, format, args);
+  va_end(args);
+  if (len > 0) {
+    ttygui_out_len += len;
+  }
+}
+
+
+
+static inline void ttygui_putc(uint8_t c)
+{
+  if (ttygui_out_len >= TTYGUI_OUT_SIZE) {
+    ttygui_flush();
+  }
+  ttygui_out[ttygui_out_len++] = c;
+}
+
+
+
+static void ttygui_exit_handler(void)
+{
+  ttygui_printf("\x1b[0m\x1b[?25h\x1b[%d;1H\r\n", TTYGUI_ROWS);
+  ttygui_flush();
+  if (ttygui_tio_valid) {
+    tcsetattr(STDIN_FILENO, TCSANOW, &ttygui_tio_saved);
+  }
+}
+
+
+
+static void ttygui_clear(int cols)
+{
+  /* Everything is sent again after a clear or a change of width. */
+  ttygui_printf("\x1b[0m\x1b[H\x1b[2J");
+  ttygui_attribute = 0;
+  ttygui_row = 0;
+  ttygui_col = 0;
+  ttygui_cols = cols;
+  for (int row = 0; row < TTYGUI_ROWS; row++) {
+    for (int col = 0; col < TTYGUI_COLS_MAX; col++) {
+      ttygui_shadow[row][col].byte = ' ';
+      ttygui_shadow[row][col].attribute = 0;
+    }
+  }
+}
+
+
+
+int ttygui_init(void)
+{
+  struct termios tio;
+
+  if (tcgetattr(STDIN_FILENO, &ttygui_tio_saved) == -1) {
+    fprintf(stderr, "Standard input is not a terminal\n");
+    return -1;
+  }
+  ttygui_tio_valid = true;
+  atexit(ttygui_exit_handler);
+
+  tio = ttygui_tio_saved;
+  cfmakeraw(&tio);
+  tcsetattr(STDIN_FILENO, TCSANOW, &tio);
+
+  /* The emulated cursor is drawn as a cell, the host one is hidden. */
+  ttygui_printf("\x1b[?25l");
+  ttygui_clear(terminal_columns());
+  ttygui_flush();
+  return 0;
+}
+
+
+
+static void ttygui_attribute_set(uint8_t attribute)
+{
+  static const uint8_t sgr[5] = { 0, 1, 4, 5, 7 }; /* By attribute bit. */
+  bool first = true;
+
+  if (attribute == ttygui_attribute) {
+    return;
+  }
+
+  /* Attributes can only be turned off all at once. */
+  ttygui_printf("\x1b[");
+  if (ttygui_attribute & ~attribute) {
+    ttygui_printf("0");
+    first = false;
+    ttygui_attribute = 0;
+  }
+  for (int bit = TERMINAL_ATTRIBUTE_BOLD; bit <= TERMINAL_ATTRIBUTE_REVERSE;
+       bit++) {
+    if (((attribute >> bit) & 0x1) && ! ((ttygui_attribute >> bit) & 0x1)) {
+      ttygui_printf(first ? "%d" : ";%d", sgr[bit]);
+      first = false;
+    }
+  }
+  ttygui_printf("m");
+  ttygui_attribute = attribute;
+}
+
+
+
+static void ttygui_glyph(uint8_t byte)
+{
+  /* Latin-1 as UTF-8, control characters as blanks. */
+  if (byte < 0x20 || byte == 0x7F || (byte >= 0x80 && byte < 0xA0)) {
+    ttygui_putc(' ');
+  } else if (byte < 0x80) {
+    ttygui_putc(byte);
+  } else {
+    ttygui_putc(0xC0 | (byte >> 6));
+    ttygui_putc(0x80 | (byte & 0x3F));
+  }
+}
+
+
+
+static void ttygui_cell(int row, int col, terminal_char_t c)
+{
+  ttygui_attribute_set(c.attribute);
+  ttygui_glyph(c.byte);
+  ttygui_shadow[row][col] = c;
+
+  /* The host may wrap after the last column, so the position is lost. */
+  ttygui_col = (col + 1 < ttygui_cols) ? col + 1 : -1;
+  ttygui_row = (ttygui_col == -1) ? -1 : row;
+}
+
+
+
+static void ttygui_move(int row, int col)
+{
+  int gap;
+  bool same;
+
+  if (row == ttygui_row && col == ttygui_col) {
+    return;
+  }
+
+  /* A short run of unchanged cells is cheaper to send again than a move,
+     if they need no attribute change. */
+  if (row == ttygui_row && col > ttygui_col) {
+    gap = col - ttygui_col;
+    same = (gap <= TTYGUI_GAP_MAX);
+    for (int i = ttygui_col; same && i < col; i++) {
+      same = (ttygui_shadow[row][i].attribute == ttygui_attribute);
+    }
+    if (same) {
+      for (int i = ttygui_col; i < col; i++) {
+        ttygui_glyph(ttygui_shadow[row][i].byte);
+      }
+    } else {
+      ttygui_printf("\x1b[%dC", gap);
+    }
+  } else if (col == 0 && row == ttygui_row + 1) {
+    ttygui_printf("\r\n");
+  } else if (col == 0) {
+    ttygui_printf("\x1b[%dH", row + 1);
+  } else {
+    ttygui_printf("\x1b[%d;%dH", row + 1, col + 1);
+  }
+  ttygui_row = row;
+  ttygui_col = col;
+}
+
+
+
+static void ttygui_input(void)
+{
+  struct pollfd pfd;
+  uint8_t buffer[TTYGUI_IN_SIZE];
+  ssize_t len;
+
+  pfd.fd = STDIN_FILENO;
+  pfd.events = POLLIN;
+  if (poll(&pfd, 1, 0) <= 0) {
+    return;
+  }
+  len = read(STDIN_FILENO, buffer, TTYGUI_IN_SIZE);
+
+  /* Taken before anything is sent, or a fast echo could arrive first. */
+  if (len > 0) {
+    latency_key(timer_us());
+  }
+  for (ssize_t i = 0; i < len; i++) {
+    if (buffer[i] == TTYGUI_QUIT) {
+      exit(0);
+    }
+
+    /* Cursor keys from the host terminal follow the emulated key mode. */
+    switch (ttygui_key) {
+    case TTYGUI_KEY_ESCAPE:
+      if (buffer[i] == '[' || buffer[i] == 'O') {
+        ttygui_key_held = buffer[i];
+        ttygui_key = TTYGUI_KEY_CURSOR;
+        continue;
+      }
+      break;
+
+    case TTYGUI_KEY_CURSOR:
+      ttygui_key = TTYGUI_KEY_NONE;
+      if (buffer[i] >= 'A' && buffer[i] <= 'D') {
+        if (terminal_cursor_key_code() != 0) {
+          eia_send(terminal_cursor_key_code());
+        }
+      } else {
+        eia_send(ttygui_key_held);
+      }
+      break;
+
+    default:
+      break;
+    }
+    if (buffer[i] == 0x1B) {
+      ttygui_key = TTYGUI_KEY_ESCAPE;
+    } else if (ttygui_key == TTYGUI_KEY_ESCAPE) {
+      ttygui_key = TTYGUI_KEY_NONE;
+    }
+    eia_send(buffer[i]);
+  }
+}
+
+
+
+void ttygui_update(void)
+{
+  int row, col;
+  int cells = 0;
+  uint32_t start;
+  terminal_char_t c;
+
+  ttygui_input();
+
+  /* Paced, so a busy screen is sent as a few large updates. */
+  while ((timer_us() - ttygui_time) < TTYGUI_FRAME_US) {
+    usleep(1000);
+    ttygui_input();
+  }
+  ttygui_time = timer_us();
+
+  start = profile_pass_start();
+  latency_pass_start();
+  trace(TRACE_RENDER_START, 0, 0);
+
+  if (terminal_columns() != ttygui_cols) {
+    ttygui_clear(terminal_columns());
+  }
+  for (row = 0; row < TTYGUI_ROWS; row++) {
+    for (col = 0; col < ttygui_cols; col++) {
+      if (! terminal_char_changed(row, col)) {
+        continue;
+      }
+      /* Blinking cells always count as changed, the host blinks them. */
+      c = terminal_char_get(row, col);
+      if (c.byte == ttygui_shadow[row][col].byte &&
+          c.attribute == ttygui_shadow[row][col].attribute) {
+        continue;
+      }
+      ttygui_move(row, col);
+      ttygui_cell(row, col, c);
+      cells++;
+    }
+  }
+  ttygui_flush();
+
+  stats_count(STATS_RENDER_PASSES);
+  stats_count_add(STATS_CELLS_RENDERED, cells);
+  stats_peak_update(STATS_PEAK_CELLS_PER_PASS, cells);
+  trace(TRACE_RENDER_END, 0, cells);
+
+  profile_pass_end(start, cells, TTYGUI_FRAME_US);
+  latency_pass_end();
+}
+
+
+
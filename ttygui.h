@@ -0,0 +1,7 @@
+#ifndef _TTYGUI_H
+#define _TTYGUI_H
+
+int ttygui_init(void);
+void ttygui_update(void);
+
+#endif /* _TTYGUI_H */
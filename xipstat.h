@@ -0,0 +1,11 @@
+#ifndef _XIPSTAT_H
+#define _XIPSTAT_H
+
+#include "diag.h"
+
+#define DIAG_XIP 904
+
+void xipstat_boot_benchmark(void);
+void xipstat_report(diag_put_t put);
+
+#endif /* _XIPSTAT_H */
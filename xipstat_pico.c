@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdint.h>
+#include "hardware/structs/xip_ctrl.h"
+#include "xipstat.h"
+#include "diag.h"
+#include "terminal.h"
+#include "palvideo.h"
+#include "timer.h"
+
+#define XIPSTAT_WORKLOAD_SIZE 4096
+
+typedef struct xipstat_run_s {
+  uint32_t us;
+  uint32_t hit;
+  uint32_t access;
+} xipstat_run_t;
+
+static xipstat_run_t xipstat_parse;
+static xipstat_run_t xipstat_render;
+
+#ifdef BOOT_BENCHMARK
+static uint8_t xipstat_workload[XIPSTAT_WORKLOAD_SIZE];
+#endif /* BOOT_BENCHMARK */
+
+
+
+static inline void xipstat_clear(void)
+{
+  /* Writing any value clears the counters. */
+  xip_ctrl_hw->ctr_hit = 0;
+  xip_ctrl_hw->ctr_acc = 0;
+}
+
+
+
+#ifdef BOOT_BENCHMARK
+static void xipstat_cold(void)
+{
+  /* Reading the flush register stalls until the flush is done. */
+  xip_ctrl_hw->flush = 1;
+  (void)xip_ctrl_hw->flush;
+  xipstat_clear();
+}
+
+
+
+static void xipstat_run_end(xipstat_run_t *run, uint32_t start)
+{
+  run->us = timer_us() - start;
+  run->hit = xip_ctrl_hw->ctr_hit;
+  run->access = xip_ctrl_hw->ctr_acc;
+}
+
+
+
+static int xipstat_workload_fill(void)
+{
+  int len = 0;
+  int line = 0;
+
+  /* Text with attributes, cursor movement and scrolling. */
+  while (len < (XIPSTAT_WORKLOAD_SIZE - 64)) {
+    len += snprintf((char *)&xipstat_workload[len], 64,
+      "\x1b[1m%04d\x1b[0m The quick brown \x1b[7mfox\x1b[0m jumps.\r\n",
+      line++);
+    if ((line % 20) == 0) {
+      len += snprintf((char *)&xipstat_workload[len], 64, "\x1b[H\x1b[2J");
+    }
+  }
+  return len;
+}
+#endif /* BOOT_BENCHMARK */
+
+
+
+void xipstat_boot_benchmark(void)
+{
+#ifdef BOOT_BENCHMARK
+  uint32_t start;
+  int len;
+
+  /* From a cold cache, once before core1 is launched, so the difference
+     made by SRAM_HOT_PATHS shows between two builds. */
+  len = xipstat_workload_fill();
+
+  xipstat_cold();
+  start = timer_us();
+  for (int i = 0; i < len; i++) {
+    terminal_handle_byte(xipstat_workload[i]);
+  }
+  xipstat_run_end(&xipstat_parse, start);
+
+  xipstat_cold();
+  start = timer_us();
+  palvideo_update();
+  xipstat_run_end(&xipstat_render, start);
+
+  terminal_init();
+  xipstat_clear();
+#endif /* BOOT_BENCHMARK */
+}
+
+
+
+static void xipstat_run_report(diag_put_t put, const char *name,
+  const xipstat_run_t *run)
+{
+  if (run->access == 0) {
+    return;
+  }
+  diag_printf(put, "boot_%s_us=%lu\n", name, (unsigned long)run->us);
+  diag_printf(put, "boot_%s_xip=%lu/%lu\n", name, (unsigned long)run->hit,
+    (unsigned long)run->access);
+}
+
+
+
+void xipstat_report(diag_put_t put)
+{
+  uint32_t hit = xip_ctrl_hw->ctr_hit;
+  uint32_t access = xip_ctrl_hw->ctr_acc;
+
+  /* Cache hits out of all XIP accesses since the previous report. */
+  xipstat_clear();
+  diag_printf(put, "xip=%lu/%lu\n", (unsigned long)hit,
+    (unsigned long)access);
+  if (access > 0) {
+    diag_printf(put, "xip_hit_permille=%lu\n",
+      (unsigned long)(((uint64_t)hit * 1000) / access));
+  }
+  xipstat_run_report(put, "parse", &xipstat_parse);
+  xipstat_run_report(put, "render", &xipstat_render);
+}
+
+
+